@@ -52,25 +52,75 @@ const u32 crc32_table[256] __attribute__((section(".dtcm"))) = {
     0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94, 0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D,  // 248 [0xF8 .. 0xFF]
 };
 
+// ------------------------------------------------------------------------------------
+// Slice-by-8 tables - crc32_slice[0] is the classic table above and each of the others
+// advances the CRC by one more byte so we can fold in 8 bytes at a time with 8 lookups
+// rather than 8 dependent shift/lookup steps. Built once on first use (8K of main RAM).
+// ------------------------------------------------------------------------------------
+static u32 crc32_slice[8][256];
+static u8  crc32_slice_ready = 0;
+
+static void crc32_slice_init(void)
+{
+    for (int i=0; i<256; i++)
+    {
+        u32 crc = crc32_table[i];
+        crc32_slice[0][i] = crc;
+        for (int slice=1; slice<8; slice++)
+        {
+            crc = (crc >> 8) ^ crc32_table[crc & 0xFF];
+            crc32_slice[slice][i] = crc;
+        }
+    }
+    crc32_slice_ready = 1;
+}
+
+// ------------------------------------------------------------------------------------
+// Fold a buffer into a running CRC (start with 0xFFFFFFFF and invert at the end). The
+// ARM9 is little-endian which is exactly the order the reflected CRC32 wants.
+// ------------------------------------------------------------------------------------
+u32 updateCRC32(u32 crc, const u8 *buf, u32 size)
+{
+    if (!crc32_slice_ready) crc32_slice_init();
+
+    while (size && ((u32)buf & 3))  // Byte at a time until we are word aligned
+    {
+        crc = (crc >> 8) ^ crc32_table[(crc ^ *buf++) & 0xFF];
+        size--;
+    }
+
+    while (size >= 8)
+    {
+        u32 one = *(const u32*)(buf+0) ^ crc;
+        u32 two = *(const u32*)(buf+4);
+        crc = crc32_slice[7][one & 0xFF]         ^ crc32_slice[6][(one >> 8) & 0xFF] ^
+              crc32_slice[5][(one >> 16) & 0xFF] ^ crc32_slice[4][one >> 24]         ^
+              crc32_slice[3][two & 0xFF]         ^ crc32_slice[2][(two >> 8) & 0xFF] ^
+              crc32_slice[1][(two >> 16) & 0xFF] ^ crc32_slice[0][two >> 24];
+        buf  += 8;
+        size -= 8;
+    }
+
+    while (size--)                  // And whatever is left over
+    {
+        crc = (crc >> 8) ^ crc32_table[(crc ^ *buf++) & 0xFF];
+    }
+
+    return crc;
+}
+
 // --------------------------------------------------
 // Compute the CRC of a memory buffer of any size...
 // --------------------------------------------------
 u32 getCRC32(u8 *buf, u32 size)
 {
-    u32 crc = 0xFFFFFFFF;
-
-    for (int i=0; i < size; i++)
-    {
-        crc = (crc >> 8) ^ crc32_table[(crc & 0xFF) ^ (u8)buf[i]]; 
-    }
-    
-    return ~crc;
+    return ~updateCRC32(0xFFFFFFFF, buf, size);
 }
 
 // ------------------------------------------------------------------------------------
 // Read the file in and compute CRC... it's a bit slow but good enough and accurate!
 // ------------------------------------------------------------------------------------
-ITCM_CODE u32 getFileCrc(const char* filename)
+u32 getFileCrc(const char* filename)
 {
     extern u32 file_size;
     u32 crc = 0xFFFFFFFF;
@@ -80,11 +130,8 @@ ITCM_CODE u32 getFileCrc(const char* filename)
     u32 size=0;
     while ((bytesRead = fread(fileBuf, 1, sizeof(fileBuf), file)) > 0)
     {
-        for (int i=0; i < bytesRead; i++)
-        {
-            size++;
-            crc = (crc >> 8) ^ crc32_table[(crc & 0xFF) ^ (u8)fileBuf[i]]; 
-        }
+        crc = updateCRC32(crc, fileBuf, bytesRead);
+        size += bytesRead;
     }
     fclose(file);
     
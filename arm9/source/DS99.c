@@ -70,6 +70,12 @@ u16 timingFrames    __attribute__((section(".dtcm"))) = 0;
 u8  bShowDebug      __attribute__((section(".dtcm"))) = 0;
 u8  debug_screen = 0;
 
+#ifdef TMS9900_MEM_STATS
+#define DEBUG_SCREENS   6   // The extra page shows the memory access counts
+#else
+#define DEBUG_SCREENS   5
+#endif
+
 // ------------------------------------------------------------------------------------------------
 // For the various BIOS files ... only the TI BIOS Roms are required - everything else is optional.
 // ------------------------------------------------------------------------------------------------
@@ -1429,9 +1435,20 @@ void __attribute__ ((noinline)) ds99_show_debugger(void)
         if (tms9900.illegalOPs)
         {
             sprintf(tmpBuf, "ILOP: %6d", tms9900.illegalOPs);
-            DS_Print(20,idx,6,tmpBuf);
+            DS_Print(20,idx++,6,tmpBuf);
         }
 
+        // How much of the CPU time since the last update was skipped by idle loop fast-forwarding
+        extern u32 idle_skipped_cycles;
+        static u32 last_skipped_cycles = 0;
+        static u32 last_cpu_cycles = 0;
+        u32 skipped = idle_skipped_cycles - last_skipped_cycles;
+        u32 elapsed = tms9900.cycles - last_cpu_cycles;
+        sprintf(tmpBuf, "IDLE: %3u%% FF", (elapsed ? (u32)(((u64)skipped * 100) / elapsed) : 0));
+        DS_Print(20,idx++,6,tmpBuf);
+        last_skipped_cycles = idle_skipped_cycles;
+        last_cpu_cycles = tms9900.cycles;
+
         // Sound Register debug
         idx = 1;
         sprintf(tmpBuf, "SN0 %04X %04X %04X", snti99.ch0Frq, snti99.ch0Reg, snti99.ch0Att);
@@ -1458,6 +1475,7 @@ void __attribute__ ((noinline)) ds99_show_debugger(void)
         DS_Print(0,idx++,6,tmpBuf);
         sprintf(tmpBuf, "CPU.WP     %04X", tms9900.WP);
         DS_Print(0,idx++,6,tmpBuf);
+        TMS9900_SyncStatus();
         sprintf(tmpBuf, "CPU.ST     %04X", tms9900.ST);
         DS_Print(0,idx++,6,tmpBuf);
         sprintf(tmpBuf, "CPU.GR     %04X", tms9900.gromAddress);
@@ -1471,10 +1489,11 @@ void __attribute__ ((noinline)) ds99_show_debugger(void)
         sprintf(tmpBuf, "CPU.Cycl %10u", tms9900.cycles);
         DS_Print(0,idx++,6,tmpBuf);
         idx++;
-        sprintf(tmpBuf, "SAMS %02X %02X %02X %02X %02X %02X %02X %02X H%02X", theSAMS.bankMapSAMS[2], theSAMS.bankMapSAMS[3],
-                theSAMS.bankMapSAMS[0xA], theSAMS.bankMapSAMS[0xB], theSAMS.bankMapSAMS[0xC], theSAMS.bankMapSAMS[0xD], theSAMS.bankMapSAMS[0xE], theSAMS.bankMapSAMS[0xF], sams_highwater_bank);
+        sprintf(tmpBuf, "SAMS %02X %02X %02X %02X %02X %02X %02X %02X", theSAMS.bankMapSAMS[2], theSAMS.bankMapSAMS[3],
+                theSAMS.bankMapSAMS[0xA], theSAMS.bankMapSAMS[0xB], theSAMS.bankMapSAMS[0xC], theSAMS.bankMapSAMS[0xD], theSAMS.bankMapSAMS[0xE], theSAMS.bankMapSAMS[0xF]);
+        DS_Print(0,idx++,6,tmpBuf);
+        sprintf(tmpBuf, "SAMS.Pages %4d H%03X", sams_pages_used, sams_highwater_bank);
         DS_Print(0,idx++,6,tmpBuf);
-        if ((vusCptVBL & 3) == 0) sams_highwater_bank = 0;  // Reset this periodically (every 4 seconds).
     }
     else if (debug_screen == 1)   // Show 2nd page of debug info
     {
@@ -1529,6 +1548,46 @@ void __attribute__ ((noinline)) ds99_show_debugger(void)
             DS_Print(0,idx++,6,tmpBuf);
         }
     }
+#ifdef TMS9900_MEM_STATS
+    else if (debug_screen == 5) // Show memory accesses per second - by memory type first and then 16 pages at a time
+    {
+        static u32 lastType[3][MF_UNUSED+1];
+        static u32 lastPage[3][256];
+        char label[8];
+
+        idx = 1;
+        sprintf(tmpBuf, "%-6s%8s %8s %8s", (mem_debug ? "PAGE":"TYPE"), "READ/S", "WRITE/S", "FETCH/S");
+        DS_Print(0,idx++,6,tmpBuf);
+        if (mem_debug == 0)
+        {
+            for (u8 type=0; (type <= MF_UNUSED) && (idx < 20); type++)
+            {
+                if ((memStatsType[MEM_STAT_READ][type] | memStatsType[MEM_STAT_WRITE][type] | memStatsType[MEM_STAT_FETCH][type]) == 0) continue;
+                sprintf(tmpBuf, "%-6s%8u %8u %8u", memStatsTypeName[type],
+                        (unsigned int)(memStatsType[MEM_STAT_READ][type]  - lastType[MEM_STAT_READ][type]),
+                        (unsigned int)(memStatsType[MEM_STAT_WRITE][type] - lastType[MEM_STAT_WRITE][type]),
+                        (unsigned int)(memStatsType[MEM_STAT_FETCH][type] - lastType[MEM_STAT_FETCH][type]));
+                DS_Print(0,idx++,6,tmpBuf);
+            }
+        }
+        else
+        {
+            for (u16 page=(mem_debug-1)*16; page < mem_debug*16; page++)
+            {
+                sprintf(label, ">%02X00", page);
+                sprintf(tmpBuf, "%-6s%8u %8u %8u", label,
+                        (unsigned int)(memStatsPage[MEM_STAT_READ][page]  - lastPage[MEM_STAT_READ][page]),
+                        (unsigned int)(memStatsPage[MEM_STAT_WRITE][page] - lastPage[MEM_STAT_WRITE][page]),
+                        (unsigned int)(memStatsPage[MEM_STAT_FETCH][page] - lastPage[MEM_STAT_FETCH][page]));
+                DS_Print(0,idx++,6,tmpBuf);
+            }
+        }
+        while (idx < 20) DS_Print(0,idx++,6,"                                ");
+
+        memcpy(lastType, memStatsType, sizeof(lastType));
+        memcpy(lastPage, memStatsPage, sizeof(lastPage));
+    }
+#endif
 }
 
 // -------------------------------------------------------------------
@@ -1621,7 +1680,10 @@ u8 __attribute__ ((noinline)) handle_touch_input(void)
             break;
 
         case META_KEY_DEBUG_NEXT:
-            debug_screen = (debug_screen+1) % 5; // We have several debug screens we can flip-flop between.
+#ifdef TMS9900_MEM_STATS
+            if (debug_screen == 5) MemStats_Dump();     // Leaving the memory access page writes the counts out to the SD card
+#endif
+            debug_screen = (debug_screen+1) % DEBUG_SCREENS; // We have several debug screens we can flip-flop between.
             mmEffect(SFX_KEYCLICK);
             WAITVBL;
             ds99_clear_debugger();
@@ -2134,9 +2196,9 @@ void irqVBlank(void)
 // -------------------------------------------------------------------------------------------
 void StealVideoRAM(void)
 {
-    vramSetBankB(VRAM_B_LCD);   // Not using this for video but 128K of faster RAM always useful! Mapped at 0x06820000 (used for opcode tables)
-    vramSetBankD(VRAM_D_LCD);   // Not using this for video but 128K of faster RAM always useful! Mapped at 0x06860000 (used for opcode tables)
-    vramSetBankE(VRAM_E_LCD);   // Not using this for video but 64K of faster RAM always useful!  Mapped at 0x06880000 (unused)
+    vramSetBankB(VRAM_B_LCD);   // Not using this for video but 128K of faster RAM always useful! Mapped at 0x06820000 (unused)
+    vramSetBankD(VRAM_D_LCD);   // Not using this for video but 128K of faster RAM always useful! Mapped at 0x06860000 (unused - but the screenshot capture scribbles here)
+    vramSetBankE(VRAM_E_LCD);   // Not using this for video but 64K of faster RAM always useful!  Mapped at 0x06880000 (used for the decoded instruction cache)
     vramSetBankF(VRAM_F_LCD);   // Not using this for video but 16K of faster RAM always useful!  Mapped at 0x06890000 (unused)
     vramSetBankG(VRAM_G_LCD);   // Not using this for video but 16K of faster RAM always useful!  Mapped at 0x06894000 (unused)
     vramSetBankH(VRAM_H_LCD);   // Not using this for video but 32K of faster RAM always useful!  Mapped at 0x06898000 (cache the system console GROM 24K - 8K free at beginning)
@@ -2238,7 +2300,7 @@ static void StartupMemoryAllocation(void)
         SharedMemBufferBig = malloc(10 * 1024 * 1024);  // A full 10MB of big buffer for CART/SAMS use
         MAX_CART_SIZE = (u32)(8192 * 1024);             // 8MB (8192K) Max Cart for DSi
         MemCART = SharedMemBufferBig;                   // Set the Cart memory to this large buffer
-        MemSAMS = SharedMemBufferBig+MAX_CART_SIZE;     // And SAMS is always the back-end of this buffer
+        MemSAMS = SharedMemBufferBig+MAX_CART_SIZE;     // And SAMS pages come from the back-end of this buffer (plus any cart space not used)
     }
     else
     {
@@ -23,6 +23,7 @@ extern u8 *SharedMemBuffer;     // A bit of shared memory for the system to use
 extern u8 *SharedMemBufferBig;  // For the DSi we use this to handle the CART + SAMS trade-off (10MB total)
 extern volatile int ds_vblank_count;
 extern u32 file_size;
+extern u32 cartPreloaded;       // Bytes of the selected cart image already sitting in MemCART from the CRC pass (0 if none)
 
 #define WAITVBL {swiWaitForVBlank(); swiWaitForVBlank(); swiWaitForVBlank(); swiWaitForVBlank(); swiWaitForVBlank();}
 
@@ -1308,13 +1308,13 @@ void SetDefaultGameConfig(void)
     myConfig.maxSprites  = globalConfig.maxSprites;
     myConfig.memWipe     = 0;
     myConfig.capsLock    = 0;
-    myConfig.RAMMirrors  = (isDSiMode() ? 1:0);    // For DSi we enable the RAM mirrors
+    myConfig.reservedR   = 0;
     myConfig.overlay     = globalConfig.overlay;
     myConfig.emuSpeed    = 0;
     myConfig.machineType = globalConfig.machineType;
     myConfig.cartType    = 0;   // Normal
     myConfig.dpadDiagonal= 0;   // Normal
-    myConfig.spriteCheck = 0;   // Normal
+    myConfig.reservedS   = 0;
     myConfig.sounddriver = 0;   // Default to having speech module attached
     myConfig.reservedJ   = 0;
     myConfig.reservedK   = 0;
@@ -1357,15 +1357,8 @@ void SetDefaultGameConfig(void)
     if (file_crc == 0xcf6c8d64) myConfig.dpadDiagonal = 1;  // Topper wants to use diagonal directions
     if (file_crc == 0x3c124691) myConfig.dpadDiagonal = 1;  // Topper wants to use diagonal directions
 
-    if (file_crc == 0x2715313f) myConfig.spriteCheck = 2;   // The megademo ROM needs it this fast at least
-    if (file_crc == 0xe92f15ff) myConfig.spriteCheck = 2;   // The megademo DSK needs it this fast at least
-
     if (file_crc == 0x0e34d709) myConfig.sounddriver = 2;   // Dragon's Lair Demo needs the new Direct Wave handling for speech
 
-    if (file_crc == 0x478d9835) myConfig.RAMMirrors = 1;    // TI-99/4a Congo Bongo requires RAM mirrors to run properly
-    if (file_crc == 0x5f85e8ed) myConfig.RAMMirrors = 1;    // TI-99/4a Congo Bongo requires RAM mirrors to run properly (32K FinalGrom ver)
-    if (file_crc == 0x0b9ad832) myConfig.RAMMirrors = 1;    // TI-99/4a Buck Rogers requires RAM mirrors to run properly
-
     if (file_crc == 0x3f4c4fe5) myConfig.machineType = MACH_TYPE_SAMS_1MB; // Dungeons of Asgard 0.4.0 uses SAMS
     if (file_crc == 0x32b842e2) myConfig.machineType = MACH_TYPE_SAMS_1MB; // Dungeons of Asgard 0.5.0 uses SAMS
     
@@ -1491,9 +1484,7 @@ struct options_t Option_Table[2][20] =
         {"CART TYPE",      {"NORMAL", "SUPERCART RAM", "MINIMEM 4K", "MBX NO RAM", "MBX WITH RAM", "PAGED CRU"},                             &myConfig.cartType,     6},
         {"EMU SPEED",      {"NORMAL", "110 PERCENT", "120 PERCENT", "130 PERCENT", "140 PERCENT", "150 PERCENT", "90 PERCENT", "80 PERCENT"},&myConfig.emuSpeed,     8},
         {"CAPS LOCK",      {"OFF", "ON"},                                                                                                    &myConfig.capsLock,     2},
-        {"RAM MIRRORS",    {"OFF", "ON"},                                                                                                    &myConfig.RAMMirrors,   2},
         {"RAM WIPE",       {"CLEAR", "RANDOM",},                                                                                             &myConfig.memWipe,      2},
-        {"SPRITE CHECK",   {"NORMAL (32/64)", "4 SCANLINES", "8 SCANLINES", "16 SCANLINES", "32 SCANLINES", "64 SCANLINES", "END OF FRAME"}, &myConfig.spriteCheck,  7},
         {"SOUND DRIVER",   {"NORMAL", "NO SPEECH", "WAVE DIRECT"},                                                                           &myConfig.sounddriver,  3},
         {"NDS DPAD",       {"NORMAL", "DIAGONALS",},                                                                                         &myConfig.dpadDiagonal, 2},
         {NULL,             {"",      ""},                                                                                                    NULL,                   1},
@@ -1640,6 +1631,7 @@ struct options_t GlobalOption_Table[] =
     {"DEF SPRITES",    {"4", "32"},                                                              &globalConfig.maxSprites,    2},
     {"DEF FRAMESKP",   {"OFF", "ON"},                                                            &globalConfig.frameSkip,     2},
     {"FLOPPY SFX",     {"OFF", "ON"},                                                            &globalConfig.floppySound,   2},
+    {"BIG CARTS",      {"COMPRESSED RAM", "STREAM FROM SD"},                                     &globalConfig.cartStreamSD,  2},
 
     {NULL,             {"",      ""},                                           NULL,                        1},
 };
@@ -60,7 +60,7 @@ struct __attribute__((__packed__)) GlobalConfig_t
     u8  overlay;
     u8  floppySound;
     u8  frameSkip;
-    u8  reservedI;
+    u8  cartStreamSD;   // Big carts: 0 = held compressed in RAM (the default - existing configs have 0 here), 1 = streamed from the SD card
     u8  reservedJ;
     u8  reservedK;
     u8  reservedL;
@@ -81,13 +81,13 @@ struct __attribute__((__packed__)) Config_t
     u8  memWipe;
     u8  isPAL;
     u8  capsLock;
-    u8  RAMMirrors;
+    u8  reservedR;     // Was RAM mirrors on/off - the scratchpad is now always mirrored
     u8  overlay;
     u8  emuSpeed;
     u8  machineType;
     u8  cartType;
     u8  dpadDiagonal;
-    u8  spriteCheck;
+    u8  reservedS;     // Was the sprite collision check interval - collisions are now found exactly as sprites are drawn
     u8  sounddriver;
     u8  reservedJ;
     u8  reservedK;
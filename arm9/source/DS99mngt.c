@@ -27,12 +27,57 @@
 #include "DS99mngt.h"
 #include "DS99_utils.h"
 #include "disk.h"
+#include "scheduler.h"
 #include "pcode.h"
 #include "SAMS.h"
+#include "cartstream.h"
 #include "speech.h"
 
 u32 file_crc __attribute__((section(".dtcm")))  = 0x00000000;  // Our global file CRC32 to uniquiely identify this game. For split files (C/D/G) it will be the CRC of the main file (C or G if no C)
 
+u32  cartPreloaded = 0;                         // Bytes of the cart image already read into MemCART while computing the CRC (0 if none)
+static char cartPreloadName[MAX_ROM_LENGTH];    // And which file that was - so we only trust it for the same game
+
+// ------------------------------------------------------------------------------------
+// Read a full cart image into MemCART a bank at a time. Inverted images ('9' files) have
+// each bank dropped straight into its final slot so there is no swapping afterwards, and
+// if a CRC is wanted it's folded in while the bank is still fresh. A short final bank is
+// padded out with 0xFF just as an empty cart slot would read. Returns the bytes read.
+// ------------------------------------------------------------------------------------
+static u32 ReadCartImage(FILE *infile, u8 inverted, u32 *crc)
+{
+    fseek(infile, 0, SEEK_END);
+    u32 size = ftell(infile);
+    fseek(infile, 0, SEEK_SET);
+    if (size > MAX_CART_SIZE) size = MAX_CART_SIZE;
+
+    u16 numBanks = (size / 0x2000) + ((size % 0x2000) ? 1:0);
+    u32 crcVal = 0xFFFFFFFF;
+
+    for (u16 i=0; i<numBanks; i++)
+    {
+        u8 *bank = MemCART + ((inverted ? (numBanks-1-i) : i) * 0x2000);
+        u32 len = fread(bank, 1, 0x2000, infile);
+        if (len < 0x2000) memset(bank+len, 0xFF, 0x2000-len);
+        if (crc) crcVal = updateCRC32(crcVal, bank, len);
+    }
+
+    if (crc) *crc = ~crcVal;
+    return size;
+}
+
+// ------------------------------------------------------------------------------------
+// Did the CRC pass already leave this file sitting in MemCART for us? The CRC pass runs
+// before this game's config is known, so it was sized against the previous game's cart
+// limit. If SAMS has since shrunk MAX_CART_SIZE, the tail of that image now overlaps the
+// SAMS pages - don't trust it and let the normal load read (and truncate) the file.
+// ------------------------------------------------------------------------------------
+static u32 CartPreloadedSize(const char *filename)
+{
+    if (cartPreloaded && (cartPreloaded <= MAX_CART_SIZE) && (strcasecmp(filename, cartPreloadName) == 0)) return file_size;
+    return 0;
+}
+
 // ---------------------------------------------------------------------------
 // Setup the main DS video modes. As usual, the top screen is primary and
 // where we map the main emulation of the TI99/4a. The bottom screen is for
@@ -112,6 +157,7 @@ u8 TI99Init(char *szGame, u8 bInitDisks)
     FILE *infile;           // We use this to read the various files in our system
     u16 numCartBanks = 1;   // Number of CART banks (8K each)
     pCodeEmulation = 0;     // Default to no p-code card emulation
+    CartStream_Close();     // And forget any cart we were streaming
 
     // ------------------------------------------------------------------
     // Grab the main 16-bit console ROM and place into our MemCPU[]
@@ -184,21 +230,18 @@ u8 TI99Init(char *szGame, u8 bInitDisks)
             {
                 tms9900.bankMask = 0x003F;
                 tmpBuf[strlen(tmpBuf)-5] = 'C';   // Try to find a 'C' file
-                infile = fopen(tmpBuf, "rb");
+                u32 numRead = CartPreloadedSize(tmpBuf);
+                infile = numRead ? NULL : fopen(tmpBuf, "rb");
                 if (infile != NULL)
                 {
-                    int numRead = fread(MemCART, 1, MAX_CART_SIZE, infile);     // Whole cart C memory as needed...
+                    numRead = ReadCartImage(infile, 0, NULL);   // Whole cart C memory as needed...
                     fclose(infile);
-                    if (numRead <= 0x2000)   // If 8K... repeat
+                }
+                if (numRead)
+                {
+                    if (numRead <= 0x2000)   // If 8K... every bank write selects this same bank (no need for copies of it)
                     {
-                        memcpy(MemCART+0x2000, MemCART, 0x2000);
-                        memcpy(MemCART+0x4000, MemCART, 0x2000);
-                        memcpy(MemCART+0x6000, MemCART, 0x2000);
-                        memcpy(MemCART+0x8000, MemCART, 0x2000);
-                        memcpy(MemCART+0xA000, MemCART, 0x2000);
-                        memcpy(MemCART+0xC000, MemCART, 0x2000);
-                        memcpy(MemCART+0xE000, MemCART, 0x2000);
-                        tms9900.bankMask = 0x0007;
+                        tms9900.bankMask = 0x0000;
                     }
                     else // More than 8K needs banking support
                     {
@@ -228,30 +271,46 @@ u8 TI99Init(char *szGame, u8 bInitDisks)
             }
             else if (fileType != '0') // Full Load - this is either going to be a non-inverted '8' file (very common) or the less common inverted type
             {
-                if (file_size >= (256 * 1024))  DS_Print(3,0,6, "LOADING ROM - PLEASE WAIT...");
-
-                infile = fopen(tmpBuf, "rb");
-                int numRead = fread(MemCART, 1, MAX_CART_SIZE, infile);   // Whole cart memory as needed....
-                fclose(infile);
-                numCartBanks = (numRead / 0x2000) + ((numRead % 0x2000) ? 1:0);
-                tms9900.bankMask = BankMasks[numCartBanks-1];
-
-                if (numCartBanks > 1)
+                u8 inverted = ((fileType == '9') || (fileType == '3'));   // '3' is deprecated but there are still cart names using it...
+
+                // ---------------------------------------------------------------------------
+                // Carts too big to hold in memory are either held compressed (if enabled and
+                // it fits) or streamed from the file a bank at a time as they are used.
+                // ---------------------------------------------------------------------------
+                numCartBanks = 0;
+                if (CartStream_Wanted(file_size))
                 {
-                    // If the image is inverted we need to swap 8K banks
-                    if ((fileType == '9') || (fileType == '3')) // '3' is deprecated but there are still cart names using it...
+                    if (!globalConfig.cartStreamSD)
                     {
-                        for (u16 i=0; i<numCartBanks/2; i++)
-                        {
-                            // Swap 8k bank...
-                            memcpy(fileBuf, MemCART + (i*0x2000), 0x2000);
-                            memcpy(MemCART+(i*0x2000), MemCART + ((numCartBanks-i-1)*0x2000), 0x2000);
-                            memcpy(MemCART + ((numCartBanks-i-1)*0x2000), fileBuf, 0x2000);
-                        }
+                        DS_Print(3,0,6, "PACKING ROM - PLEASE WAIT...");
+                        numCartBanks = CartStream_Pack(tmpBuf, file_size, inverted);
+                        DS_Print(3,0,6, "                            ");
                     }
+                    if (numCartBanks == 0) numCartBanks = CartStream_Open(tmpBuf, file_size, inverted);
                 }
 
-                memcpy(&MemCPU[0x6000], MemCART, 0x2000);   // First bank loaded into main memory
+                if (numCartBanks)
+                {
+                    tms9900.bankMask = BankMasks[numCartBanks-1];
+                    memcpy(&MemCPU[0x6000], CartStream_Bank(0), 0x2000);   // First bank loaded into main memory
+                }
+                else
+                {
+                    // The CRC pass has usually read the whole image into place already
+                    u32 numRead = CartPreloadedSize(tmpBuf);
+                    if (numRead == 0)
+                    {
+                        if (file_size >= (256 * 1024))  DS_Print(3,0,6, "LOADING ROM - PLEASE WAIT...");
+
+                        infile = fopen(tmpBuf, "rb");
+                        numRead = ReadCartImage(infile, inverted, NULL);   // Whole cart memory as needed (inverted banks go straight to their final slot)
+                        fclose(infile);
+                    }
+                    numCartBanks = (numRead / 0x2000) + ((numRead % 0x2000) ? 1:0);
+                    tms9900.bankMask = BankMasks[numCartBanks-1];
+
+                    memcpy(&MemCPU[0x6000], MemCART, 0x2000);   // First bank loaded into main memory
+                }
 
                 // And see if there is a GROM file to go along with this load...
                 tmpBuf[strlen(tmpBuf)-5] = 'G';
@@ -337,6 +396,7 @@ u8 TI99Init(char *szGame, u8 bInitDisks)
     // Ensure we're in the first bank... (which might be the only bank for 8K ROMs)
     // -----------------------------------------------------------------------------
     tms9900.cartBankPtr = MemCPU+0x6000;
+    if (myConfig.cartType == CART_TYPE_SUPERCART) WriteBankSuperCart(0);    // Super Cart RAM is banked in from the back-end of the cart buffer
 
     // -----------------------------------------------------------------------
     // If bInitDisks parameter is TRUE, we look and load up any .dsk files 
@@ -390,6 +450,14 @@ u8 TI99Init(char *szGame, u8 bInitDisks)
         }
     }
 
+    cartPreloaded = 0;  // Whatever the CRC pass left in MemCART has been used (a reset must read the file again)
+
+    // ------------------------------------------------------------------------
+    // Let the SAMS page pool use whatever part of the cart buffer we don't...
+    // ------------------------------------------------------------------------
+    if (cartStreaming) SAMS_ReserveCart(CartStream_Footprint());
+    else SAMS_ReserveCart((myConfig.cartType == CART_TYPE_SUPERCART) ? MAX_CART_SIZE : (((u32)tms9900.bankMask + 1) * 0x2000));
+
     // --------------------------------------------------------------------
     // Now that we're loaded up in memory, we set the initial CPU pointers
     // to the reset vector and kick off the CPU so we're ready to emulate!
@@ -488,36 +556,142 @@ ITCM_CODE void TI99UpdateScreen(void)
 void getfile_crc(const char *path)
 {
     DS_Print(1,5,6, "COMPUTING CRC - PLEASE WAIT...");
-    file_crc = getFileCrc(path);        // The CRC is used as a unique ID to save out High Scores and Configuration...
+
+    // ----------------------------------------------------------------------------------
+    // For plain C/8/9 cart images that will be held whole in memory, we read the image
+    // straight into MemCART and compute the CRC on the way through. TI99Init() then
+    // uses it in place instead of reading the file a second time. Anything else (RPK,
+    // GROM-only, or carts big enough to be streamed/packed) just gets the CRC pass.
+    // ----------------------------------------------------------------------------------
+    cartPreloaded = 0;
+    int len = strlen(path);
+    u8 fileType = (len >= 5) ? toupper(path[len-5]) : 0;
+    if ((len >= 5) && (len < MAX_ROM_LENGTH) && (strcasecmp(path+len-4, ".bin") == 0) &&
+        ((fileType == 'C') || (fileType == '8') || (fileType == '9') || (fileType == '3')))
+    {
+        FILE *infile = fopen(path, "rb");
+        if (infile != NULL)
+        {
+            fseek(infile, 0, SEEK_END);
+            u32 size = ftell(infile);
+            if ((size > 0) && (size <= CartStream_Limit()))
+            {
+                u8 inverted = ((fileType == '9') || (fileType == '3'));
+                file_size = ReadCartImage(infile, inverted, &file_crc);
+                cartPreloaded = ((file_size / 0x2000) + ((file_size % 0x2000) ? 1:0)) * 0x2000;
+                strcpy(cartPreloadName, path);
+            }
+            fclose(infile);
+        }
+    }
+
+    if (!cartPreloaded) file_crc = getFileCrc(path);   // The CRC is used as a unique ID to save out High Scores and Configuration...
+
     DS_Print(1,5,6, "                              ");
 }
 
 
 // --------------------------------------------------------------------------------
-// The main CPU loop... here we run one scanline of CPU instructions and then go
-// check in with the VDP video chip to see if we are done rendering a frame...
+// Scanline batching. Most games only touch the VDP registers and status during the
+// vertical blank so there is little to be gained by stopping the CPU on each of the
+// visible lines just to render that line. When nothing raster sensitive is going on
+// we let the CPU run through a whole block of lines (up to the VBlank line) in one
+// go and then render the block. Any VDP register write or status read during a block
+// first catches the rendering up to the current CPU cycle so the access lands on the
+// same line it would have... and if that access was in the visible area, we drop
+// back to the classic line-by-line interleave for the rest of this frame and the next.
+// --------------------------------------------------------------------------------
+u16 batchLines   __attribute__((section(".dtcm"))) = 0;    // Lines of the current CPU run not yet rendered (zero when the CPU isn't running)
+u32 batchStart   __attribute__((section(".dtcm"))) = 0;    // The CPU cycle at which the first of those lines began
+u8  rasterFrames __attribute__((section(".dtcm"))) = 0;    // Bit 0 set if there was a raster sensitive access this frame, bit 1 for the previous frame
+
+static inline u16 ScanlineBatchSize(void)
+{
+    if (rasterFrames) return 1;                     // Raster effects in play - line by line
+    if (myConfig.sounddriver == 2) return 1;        // Wave Direct samples the audio every scanline
+
+    // Run right up to (and including) the VBlank line so the interrupt is always raised at the end of a block
+    return (CurLine < tms_end_line) ? (tms_end_line - CurLine) : (tms_num_lines - CurLine + tms_end_line);
+}
+
+// --------------------------------------------------------------------------------
+// Called by the VDP just before a register write or status read while the CPU is
+// running. Render any lines of the block that the CPU has already finished and, if
+// we're in the visible area, cut the block short so we're back to line-by-line.
+// --------------------------------------------------------------------------------
+ITCM_CODE void ScanlineBatchCatchUp(void)
+{
+    if (batchLines > 1)
+    {
+        u16 lines = (tms9900.cycles - batchStart) / SCANLINE_CYCLES;
+        if (lines >= batchLines) lines = batchLines - 1;    // The last line of the block is always rendered when the block completes
+
+        batchStart += lines * SCANLINE_CYCLES;
+        batchLines -= lines;
+        while (lines--) Loop9918();                         // Can't be the VBlank line so there is no interrupt to worry about
+    }
+
+    u16 line = CurLine + 1;     // The line the CPU is currently running on (Loop9918 advances CurLine before rendering)
+    if ((line >= tms_start_line) && (line < tms_end_line))
+    {
+        rasterFrames |= 0x01;
+        if (batchLines > 1)
+        {
+            batchLines = 1;
+            Scheduler_Add(EVT_SCANLINE, batchStart + SCANLINE_CYCLES);
+        }
+    }
+}
+
+// --------------------------------------------------------------------------------
+// The main CPU loop... here we run one scanline (or a block of scanlines) of CPU
+// instructions and then go check in with the VDP video chip to render those lines
+// and see if we are done rendering a frame...
 // --------------------------------------------------------------------------------
 ITCM_CODE u32 LoopTMS9900()
 {
     // -----------------------------------------------------------------
-    // Run one scanline worth of CPU instructions.
+    // If nothing raster sensitive is happening, stretch the end of this
+    // scanline out to cover a whole block of lines.
+    // -----------------------------------------------------------------
+    batchLines = ScanlineBatchSize();
+    if (batchLines > 1)
+    {
+        batchStart = sched.when[EVT_SCANLINE] - SCANLINE_CYCLES;
+        Scheduler_Add(EVT_SCANLINE, sched.when[EVT_SCANLINE] + ((batchLines-1) * SCANLINE_CYCLES));
+    }
+
+    // -----------------------------------------------------------------
+    // Run the CPU for this scanline (or block of scanlines).
     //
     // Accurate emulation is enabled if we see an IDLE instruction or
-    // TIMER enabled or SAMS use as all these need special attention.
-    // Most games don't need this handling and we save the precious DS
-    // CPU cycles as this is 10-15% slower.
+    // SAMS use as these need special attention. Each combination gets
+    // its own specialized CPU core so a game only pays for the handling
+    // it needs. Most games don't need any of this and we save the
+    // precious DS CPU cycles.
+    //
+    // The CPU runs up to the next scheduled event - anything that falls
+    // due mid-line (such as the 9901 timer) is dispatched and then the
+    // CPU carries on until the scanline itself is complete.
     // -----------------------------------------------------------------
-    if (tms9900.accurateEmuFlags) TMS9900_RunAccurate();
-    else TMS9900_Run();
+    do
+    {
+        TMS9900_RunUntilEvent();
+    }
+    while (!(Scheduler_Dispatch() & (1 << EVT_SCANLINE)));
 
-    // Refresh VDP for this scanline
+    // Refresh VDP for the scanline(s) just run - only the last can be the VBlank line
+    while (--batchLines) Loop9918();
     if(Loop9918())
     {
         TMS9901_RaiseVDPInterrupt();
     }
 
     // Drop out unless end of screen is reached
-    return ((CurLine == tms_end_line) ? 0:1);
+    if (CurLine != tms_end_line) return 1;
+
+    rasterFrames = (rasterFrames << 1) & 0x02;  // Remember this frame's raster effects for one more frame
+    return 0;
 }
 
 // End of file
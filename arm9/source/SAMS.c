@@ -28,7 +28,22 @@
 
 u8 *MemSAMS             __attribute__((section(".dtcm"))) = 0;  // Allocated to support 512K for DS-Lite and 1MB/2MB for DSi and above
 SAMS theSAMS            __attribute__((section(".dtcm")));      // The entire state of the SAMS memory map handler
-u16 sams_highwater_bank __attribute__((section(".dtcm"))) = 0;  // To track how far into SAMS memory we have used
+u16 sams_highwater_bank __attribute__((section(".dtcm"))) = 0;  // To track how far into SAMS memory we have used (highest bank actually written)
+u16 sams_pages_used = 0;                                        // How many 4K banks have been given real memory (debug use and reset)
+
+// ---------------------------------------------------------------------------------------
+// SAMS memory is lazily materialized. Most SAMS software touches only a fraction of the
+// card so rather than reserve (and clear on every reset) the full 1MB-8MB, every bank
+// starts out reading as the one shared page of zeros below. The first write to a bank
+// takes a 4K page from the pool (carved top-down from the end of the big buffer) and
+// from then on the bank lives there. A reset just hands back the pages that were used.
+// ---------------------------------------------------------------------------------------
+u8  SAMS_ZeroPage[0x1000] __attribute__((aligned(4)));    // Every unwritten SAMS bank reads from here (never written to)
+static u8 *samsPage[MAX_SAMS_BANKS];                        // The real page behind each bank - NULL until the bank is first written
+static u16 samsTouched[MAX_SAMS_BANKS];                     // Which banks got a page (in allocation order) so reset only visits those
+static u16 samsRegionBank[16];                              // The bank currently mapped into each 4K region of the TI memory map
+static u8 *samsPoolFloor = 0;                               // Pages are handed out from samsPoolTop downwards but never below this
+static u8 *samsPoolTop   = 0;
 
 // ---------------------------------------------------------------------------------------
 // SAMS is handled via the CRU and has registers mapped into the DSR space but it does
@@ -113,34 +128,43 @@ void SAMS_Initialize(void)
     {
         switch (myConfig.machineType)
         {
-            case MACH_TYPE_SAMS_1MB: theSAMS.numBanks = 256;   MAX_CART_SIZE = (8*1024*1024);  break;
-            case MACH_TYPE_SAMS_2MB: theSAMS.numBanks = 512;   MAX_CART_SIZE = (8*1024*1024);  break;
-            case MACH_TYPE_SAMS_4MB: theSAMS.numBanks = 1024;  MAX_CART_SIZE = (6*1024*1024);  break;
-            case MACH_TYPE_SAMS_8MB: theSAMS.numBanks = 2048;  MAX_CART_SIZE = (2*1024*1024);  break;
-            default:                 theSAMS.numBanks = 256;   MAX_CART_SIZE = (8*1024*1024);  break;
+            case MACH_TYPE_SAMS_1MB: theSAMS.numBanks = 256;   break;
+            case MACH_TYPE_SAMS_2MB: theSAMS.numBanks = 512;   break;
+            case MACH_TYPE_SAMS_4MB: theSAMS.numBanks = 1024;  break;
+            case MACH_TYPE_SAMS_8MB: theSAMS.numBanks = 2048;  break;
+            default:                 theSAMS.numBanks = 256;   break;
         }
-        
-        MemSAMS = SharedMemBufferBig+MAX_CART_SIZE;   // SAMS is always the back-end of this big buffer (Cart Image is the front end)
+
+        // ---------------------------------------------------------------------------------
+        // The cart keeps its full 8MB. SAMS pages come from the 2MB back-end of the big
+        // buffer and, once we know how big the cart really is, from whatever part of the
+        // cart buffer it doesn't use (see SAMS_ReserveCart).
+        // ---------------------------------------------------------------------------------
+        samsPoolFloor = MemSAMS;
+        samsPoolTop   = SharedMemBufferBig + (10 * 1024 * 1024);
     }
     else
     {
         theSAMS.numBanks = 128; // On DSLite:  128 * 4K = 512K is the best we can support...
         MAX_CART_SIZE = ((myConfig.machineType != MACH_TYPE_NORMAL32K ? 256:512) * 1024);  // If we are DS-Lite/Phat, we reduce the size of the cart to support larger SAMS
+        samsPoolFloor = MemSAMS;
+        samsPoolTop   = MemSAMS + (512 * 1024);
     }
 
+    // --------------------------------------------------------------------------
+    // We don't map the MemType[] here.. only when CRU bit is written but we do
+    // hand back any SAMS pages the last game used so everything reads as zero.
+    // --------------------------------------------------------------------------
+    SAMS_ClearMemory();
+
     // For each bank... set the default memory banking pointers
     for (u8 i=0; i<16; i++)
     {
         theSAMS.bankMapSAMS[i] = i;
-        theSAMS.memoryPtr[i] = MemSAMS + (i * 0x1000);
+        theSAMS.memoryPtr[i] = SAMS_ZeroPage;
+        samsRegionBank[i] = i;
     }
 
-    // --------------------------------------------------------------------------
-    // We don't map the MemType[] here.. only when CRU bit is written but we do
-    // clear out the SAMS memory to all zeros (helps with savestate compression)
-    // --------------------------------------------------------------------------
-    memset(MemSAMS, 0x00, ((theSAMS.numBanks) * 0x1000));
-
     // -----------------------------------------------------------------
     // If we are configured for SAMS operation... set the accuracy flag
     // to map in slower (but more accurate) emulation handling.
@@ -152,9 +176,55 @@ void SAMS_Initialize(void)
         SAMS_cru_write(1,0);    // Mapper Disabled... (pass-thru mode which is basically like having a 32K expansion)
     }
 
+}
+
+// ---------------------------------------------------------------------------------------
+// Hand back every page that was given out - everything reads as zero again. This only
+// visits the banks that were actually written so it's cheap even with 8MB of SAMS.
+// ---------------------------------------------------------------------------------------
+void SAMS_ClearMemory(void)
+{
+    for (u16 i=0; i<sams_pages_used; i++)
+    {
+        samsPage[samsTouched[i]] = 0;
+    }
+    sams_pages_used = 0;
     sams_highwater_bank = 0x0000; // So we can track how much SAMS memory is being used (for debug use)
 }
 
+// ---------------------------------------------------------------------------------------
+// Called once the cart is loaded. On the DSi, anything in the 8MB cart buffer beyond the
+// cart image can be used for SAMS pages - so a small cart leaves room for the full 8MB
+// of SAMS and a big cart still gets at least the 2MB back-end (plenty for most games).
+// ---------------------------------------------------------------------------------------
+void SAMS_ReserveCart(u32 cartBytes)
+{
+    if (!isDSiMode()) return;   // The DS-Lite/Phat has its own fixed 512K of SAMS
+
+    if (cartBytes < (256 * 1024)) cartBytes = (256 * 1024);     // Some cart types use scratch space in the first 256K of the cart buffer
+    if (cartBytes > MAX_CART_SIZE) cartBytes = MAX_CART_SIZE;
+
+    samsPoolFloor = MemCART + ((cartBytes + 0xFFF) & ~0xFFF);
+}
+
+// ---------------------------------------------------------------------------------------
+// Give a bank its own 4K page (cleared to zero as that's what it has read as so far).
+// Returns NULL if the pool has run dry - the write is then lost but that only happens
+// when a game really does use more SAMS than we have memory for.
+// ---------------------------------------------------------------------------------------
+static u8 *SAMS_AllocBank(u16 bank)
+{
+    u8 *page = samsPoolTop - ((u32)(sams_pages_used + 1) * 0x1000);
+    if (page < samsPoolFloor) return 0;
+
+    memset(page, 0x00, 0x1000);
+    samsPage[bank] = page;
+    samsTouched[sams_pages_used++] = bank;
+    if (bank > sams_highwater_bank) sams_highwater_bank = bank;
+
+    return page;
+}
+
 
 // --------------------------------------------------------------------------------------
 // SAMS memory bank swapping will point into the 4K region of the large SAMS memory pool.
@@ -164,7 +234,7 @@ void SAMS_Initialize(void)
 // --------------------------------------------------------------------------------------
 const u8 IsSwappableSAMS[16] = {0,0,1,1,0,0,0,0,0,0,1,1,1,1,1,1};
 
-inline void SAMS_SwapBank(u8 memory_region, u16 bank)
+static inline void SAMS_SwapBank(u8 memory_region, u16 bank)
 {
     // -----------------------------------------------------------------------------------------
     // If the software tries to access a bank beyond the maximum configured, those upper bits 
@@ -174,9 +244,38 @@ inline void SAMS_SwapBank(u8 memory_region, u16 bank)
 
     if (IsSwappableSAMS[memory_region])    // Make sure this is an area we allow swapping... (memory_region is already masked to lower 4 bits)
     {
-        theSAMS.memoryPtr[memory_region] = MemSAMS + ((u32)bank * 0x1000);
-        if (bank > sams_highwater_bank) sams_highwater_bank = bank;
+        theSAMS.memoryPtr[memory_region] = samsPage[bank] ? samsPage[bank] : SAMS_ZeroPage;
+        samsRegionBank[memory_region] = bank;
+        TMS9900_MapSAMS(memory_region);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// The CPU is writing into a SAMS region. If the bank there is still the shared zero page
+// this is its first write - give it a real page and re-map every region it is visible in
+// (the page table then takes all further writes to this bank directly). Returns where the
+// write should go or NULL if there was no memory left to give it.
+// ---------------------------------------------------------------------------------------
+u8 *SAMS_WritePtr(u16 address)
+{
+    u8 memory_region = address >> 12;
+
+    if (theSAMS.memoryPtr[memory_region] == SAMS_ZeroPage)
+    {
+        u16 bank = samsRegionBank[memory_region];
+        if (!SAMS_AllocBank(bank)) return 0;
+
+        for (u8 i=0; i<16; i++)
+        {
+            if (IsSwappableSAMS[i] && (samsRegionBank[i] == bank))
+            {
+                theSAMS.memoryPtr[i] = samsPage[bank];
+                TMS9900_MapSAMS(i);
+            }
+        }
     }
+
+    return theSAMS.memoryPtr[memory_region] + (address & 0x0FFF);
 }
 
 // -------------------------------------------------------------------------------------------
@@ -301,22 +400,29 @@ void SAMS_EnableDisable(u8 dataBit)
             MemType[address>>4] = MF_PERIF;   // Map back to original handling (peripheral ROM)
         }
     }
+    TMS9900_MapPages(0x4000, 0x100);
 }
 
 // --------------------------------------------------------------------------------------------------
 // These 32-bit read/write functions are used only for the Load/Save state handlers in savegame.c
 // and are mainly needed so we can do simple Run-Length-Encoding (RLE) on the big SAMS memory area.
+// Banks that were never written read as zero and writing zero to them doesn't give them a page.
 // --------------------------------------------------------------------------------------------------
 u32 SAMS_Read32(u32 address)
 {
-    u32* ptr = (u32*)MemSAMS;
-    return ptr[address>>2];
+    u8 *page = samsPage[address >> 12];
+    return page ? *((u32*)(page + (address & 0x0FFF))) : 0x00000000;
 }
 
 void SAMS_Write32(u32 address, u32 data)
 {
-    u32* ptr = (u32*)MemSAMS;
-    ptr[address>>2] = data;
+    u8 *page = samsPage[address >> 12];
+    if (!page)
+    {
+        if (data == 0x00000000) return;     // Already reads as zero
+        if (!(page = SAMS_AllocBank(address >> 12))) return;
+    }
+    *((u32*)(page + (address & 0x0FFF))) = data;
 }
 
 // End of file
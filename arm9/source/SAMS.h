@@ -15,6 +15,8 @@
 #include <nds.h>
 #include <string.h>
 
+#define MAX_SAMS_BANKS  2048    // 8MB of SAMS (in 4K banks) is the most we support
+
 // ----------------------------------------------------------------------------
 // The entire state of the SAMS memory expansion card for easy access
 // ----------------------------------------------------------------------------
@@ -30,8 +32,13 @@ extern SAMS theSAMS;
 
 extern u8 *MemSAMS;
 extern u16 sams_highwater_bank;
+extern u16 sams_pages_used;
+extern u8  SAMS_ZeroPage[];
 
 extern void SAMS_Initialize(void);
+extern void SAMS_ClearMemory(void);
+extern void SAMS_ReserveCart(u32 cartBytes);
+extern u8  *SAMS_WritePtr(u16 address);
 extern void SAMS_WriteBank(u16 address, u16 data);
 extern u16  SAMS_ReadBank(u16 address);
 extern u8   SAMS_cru_read(u16 cruAddress);
@@ -0,0 +1,381 @@
+// =====================================================================================
+// Copyright (c) 2023-2026 Dave Bernazzani (wavemotion-dave)
+//
+// Copying and distribution of this emulator, its source code and associated
+// readme files, with or without modification, are permitted in any medium without
+// royalty provided this copyright notice is used and wavemotion-dave is thanked profusely.
+//
+// The DS994a emulator is offered as-is, without any warranty.
+//
+// Please see the README.md file as it contains much useful info.
+// =====================================================================================
+#include <nds.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "DS99.h"
+#include "DS99_utils.h"
+#include "cartstream.h"
+#include "CRC32.h"
+#include "cpu/tms9900/tms9900.h"
+
+// ---------------------------------------------------------------------------------------------
+// Cart images that are bigger than we are willing to hold in memory are streamed. The cart
+// buffer is split into 8K slots and only the most recently used banks are resident - a bank
+// switch to anything else reads that bank (and the banks that follow it in the file) from
+// the SD card into the least recently used slot. Most big carts have a working set of just a
+// handful of banks so after the first few seconds everything is a simple table lookup.
+//
+// By default (BIG CARTS option) the whole image is instead read once at load time and each bank
+// is kept LZ compressed in the cart buffer - most big carts are largely 0xFF padding and
+// repeated code so they shrink dramatically. Identical banks are only stored once. The banks
+// are then decompressed into a small set of slots on demand just as they'd be read from the
+// file when streaming - no SD card access at all once the game is running.
+//
+// The pre-decoded instruction cache is keyed on the bank offset (not where the bank happens
+// to be in memory) so a slot can be re-used for a different bank without any invalidation.
+// ---------------------------------------------------------------------------------------------
+#define NO_BANK     0xFFFF
+
+u8   cartStreaming  __attribute__((section(".dtcm"))) = 0;  // Set when the current cart is being streamed from the image file
+u32  cartStreamClock __attribute__((section(".dtcm"))) = 0; // Bumped on every bank access - the slot stamps are taken from this
+u16  cartStreamBanks = 0;                                   // Number of 8K banks in the image
+
+u8  *cartStreamBank[CART_STREAM_MAX_BANKS];                 // Where each cart bank is resident (NULL if it isn't)
+u32  cartStreamStamp[CART_STREAM_CACHE_DSI / 0x2000];       // When each slot was last used (for picking the LRU victim)
+static u16 slotBank[CART_STREAM_CACHE_DSI / 0x2000];        // Which cart bank each slot holds
+
+static FILE *streamFile   = NULL;   // The cart image - kept open for as long as the cart is loaded
+static u16   streamSlots  = 0;      // Number of 8K slots we cycle the banks through
+static u16   slotsUsed    = 0;      // Slots are handed out in order until they are all used - then LRU
+static u8    streamInvert = 0;      // Inverted ('9') images have the banks in reverse order in the file
+
+static u8   *packStore = NULL;                  // The compressed banks live in the cart buffer right after the slots (NULL if streaming from the file)
+static u32   packUsed  = 0;                     // How much of the store is in use
+static u32   packOffset[CART_STREAM_MAX_BANKS]; // Where each bank is in the store (identical banks share the same data)
+static u16   packLength[CART_STREAM_MAX_BANKS]; // The compressed size of each bank (a full 8K means it's stored as-is)
+static u16   packDedup[CART_PACK_DEDUP];        // Hash of the compressed data to (bank+1) for spotting identical banks
+static u16   lzHash[1 << LZ_HASH_BITS];         // The LZ compressor match finder (only used at load time)
+
+extern u8 *CartStream_Bank(u16 bank);   // The one out-of-line copy of the inline bank lookup in cartstream.h
+
+// ------------------------------------------------------------------------------------
+// How much of the cart buffer a cart may occupy. Normally that's all of it - but on the
+// DSi a 4MB or 8MB SAMS needs more than the 2MB back-end of the big buffer, and the rest
+// of its pages come from the part of the cart buffer that SAMS_ReserveCart() hands over.
+// ------------------------------------------------------------------------------------
+u32 CartStream_Limit(void)
+{
+    if (isDSiMode())
+    {
+        if (myConfig.machineType == MACH_TYPE_SAMS_8MB) return MAX_CART_SIZE - (6 * 1024 * 1024);
+        if (myConfig.machineType == MACH_TYPE_SAMS_4MB) return MAX_CART_SIZE - (2 * 1024 * 1024);
+    }
+    return MAX_CART_SIZE;
+}
+
+// ------------------------------------------------------------------------------------
+// Should this image be streamed? Only if it won't fit in the memory we'd give it and
+// only for normal ROM carts (the others re-purpose parts of the cart buffer).
+// ------------------------------------------------------------------------------------
+u8 CartStream_Wanted(u32 fileSize)
+{
+    if (myConfig.cartType != CART_TYPE_NORMAL) return 0;
+    return (fileSize > CartStream_Limit());
+}
+
+// ------------------------------------------------------------------------------------
+// Start streaming this image. Nothing is read here - the banks come in on demand.
+// Returns the number of 8K banks in the image (0 if the file could not be opened).
+// ------------------------------------------------------------------------------------
+u16 CartStream_Open(const char *filename, u32 fileSize, u8 inverted)
+{
+    CartStream_Close();
+
+    streamFile = fopen(filename, "rb");
+    if (streamFile == NULL) return 0;
+
+    cartStreamBanks  = (fileSize / 0x2000) + ((fileSize % 0x2000) ? 1:0);
+    if (cartStreamBanks > CART_STREAM_MAX_BANKS) cartStreamBanks = CART_STREAM_MAX_BANKS;
+    streamSlots  = (isDSiMode() ? CART_STREAM_CACHE_DSI : CartStream_Limit()) / 0x2000;
+    streamInvert = inverted;
+    slotsUsed    = 0;
+
+    memset(slotBank, 0xFF, sizeof(slotBank));
+    cartStreaming = 1;
+
+    return cartStreamBanks;
+}
+
+// ------------------------------------------------------------------------------------------
+// LZ compression of one 8K bank - an LZ4 style byte stream which is simple and very quick
+// to decode on the ARM9. Each sequence is a token (high nibble literal count, low nibble
+// match length - 4, either extended by 255 bytes as needed) followed by the literals, then
+// a 2-byte offset back to the match. The last sequence is just literals and the decoder
+// knows when to stop as a bank is always 8K. Returns 0 if it didn't fit in maxLen bytes.
+// ------------------------------------------------------------------------------------------
+#define LZ_PUT(byte)    do { if (op >= maxLen) return 0; dst[op++] = (byte); } while (0)
+
+static inline u16 LZ_PutLength(u8 *dst, u16 op, u16 maxLen, u16 len)
+{
+    while (len >= 255)
+    {
+        if (op >= maxLen) return 0;
+        dst[op++] = 255;
+        len -= 255;
+    }
+    if (op >= maxLen) return 0;
+    dst[op++] = len;
+    return op;
+}
+
+static u16 LZ_Pack(const u8 *src, u8 *dst, u16 maxLen)
+{
+    u16 ip = 0, anchor = 0, op = 0;
+
+    memset(lzHash, 0xFF, sizeof(lzHash));
+
+    while ((ip + LZ_MIN_MATCH) <= 0x2000)
+    {
+        u32 seq = src[ip] | (src[ip+1] << 8) | (src[ip+2] << 16) | (src[ip+3] << 24);
+        u16 hash = (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+        u16 ref = lzHash[hash];
+        lzHash[hash] = ip;
+
+        if ((ref == 0xFFFF) || memcmp(src+ref, src+ip, LZ_MIN_MATCH))
+        {
+            ip++;
+            continue;
+        }
+
+        u16 len = LZ_MIN_MATCH;
+        while (((ip + len) < 0x2000) && (src[ref+len] == src[ip+len])) len++;
+
+        u16 literals = ip - anchor;
+        u16 matchLen = len - LZ_MIN_MATCH;
+        LZ_PUT(((literals < 15 ? literals : 15) << 4) | (matchLen < 15 ? matchLen : 15));
+        if (literals >= 15) { if (!(op = LZ_PutLength(dst, op, maxLen, literals - 15))) return 0; }
+        if ((op + literals) > maxLen) return 0;
+        memcpy(dst+op, src+anchor, literals); op += literals;
+        LZ_PUT((ip - ref) & 0xFF);
+        LZ_PUT((ip - ref) >> 8);
+        if (matchLen >= 15) { if (!(op = LZ_PutLength(dst, op, maxLen, matchLen - 15))) return 0; }
+
+        ip += len;
+        anchor = ip;
+    }
+
+    if (anchor < 0x2000)    // Whatever is left over goes out as literals
+    {
+        u16 literals = 0x2000 - anchor;
+        LZ_PUT(((literals < 15 ? literals : 15) << 4));
+        if (literals >= 15) { if (!(op = LZ_PutLength(dst, op, maxLen, literals - 15))) return 0; }
+        if ((op + literals) > maxLen) return 0;
+        memcpy(dst+op, src+anchor, literals); op += literals;
+    }
+
+    return op;
+}
+
+static void LZ_Unpack(const u8 *src, u8 *dst)
+{
+    u8 *end = dst + 0x2000;
+
+    while (dst < end)
+    {
+        u8 token = *src++;
+
+        u32 len = token >> 4;
+        if (len == 15) { u8 more; do { more = *src++; len += more; } while (more == 255); }
+        memcpy(dst, src, len); dst += len; src += len;
+        if (dst >= end) break;
+
+        u8 *ref = dst - (src[0] | (src[1] << 8)); src += 2;
+        len = (token & 0x0F);
+        if (len == 15) { u8 more; do { more = *src++; len += more; } while (more == 255); }
+        len += LZ_MIN_MATCH;
+        while (len--) *dst++ = *ref++;  // Byte at a time as the match can overlap what we are writing (runs of 0xFF padding)
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+// Read the whole image and keep every bank compressed in the cart buffer. Returns the number
+// of 8K banks or 0 if the image can't be opened or won't fit even compressed (then we just
+// stream it from the file instead).
+// ------------------------------------------------------------------------------------------
+u16 CartStream_Pack(const char *filename, u32 fileSize, u8 inverted)
+{
+    CartStream_Close();
+
+    FILE *infile = fopen(filename, "rb");
+    if (infile == NULL) return 0;
+
+    u16 numBanks = (fileSize / 0x2000) + ((fileSize % 0x2000) ? 1:0);
+    if (numBanks > CART_STREAM_MAX_BANKS) numBanks = CART_STREAM_MAX_BANKS;
+
+    streamSlots = (isDSiMode() ? CART_PACK_SLOTS_DSI : CART_PACK_SLOTS_DS);
+    packStore   = MemCART + ((u32)streamSlots * 0x2000);
+    packUsed    = 0;
+    u32 storeSize = CartStream_Limit() - ((u32)streamSlots * 0x2000);
+
+    memset(packDedup, 0x00, sizeof(packDedup));
+
+    for (u16 fileBank=0; fileBank < numBanks; fileBank++)
+    {
+        size_t numRead = fread(fileBuf, 1, 0x2000, infile);
+        if (numRead < 0x2000) memset(fileBuf + numRead, 0xFF, 0x2000 - numRead);  // Last bank of an image that isn't a multiple of 8K (reads as an empty slot)
+
+        u16 bank = inverted ? (numBanks - 1 - fileBank) : fileBank;
+        u8 *dst  = packStore + packUsed;
+        u32 room = storeSize - packUsed;
+
+        // Compress it - anything that doesn't get smaller is just stored as-is
+        u16 len = LZ_Pack(fileBuf, dst, (room < 0x1FFF) ? room : 0x1FFF);
+        if (len == 0)
+        {
+            if (room < 0x2000)  // Out of room - give up and stream this one from the file
+            {
+                fclose(infile);
+                packStore = NULL;
+                packUsed = 0;
+                return 0;
+            }
+            memcpy(dst, fileBuf, 0x2000);
+            len = 0x2000;
+        }
+
+        // If we've already stored an identical bank just point at that one
+        u32 crc = getCRC32(dst, len);
+        u16 h = crc & (CART_PACK_DEDUP - 1);
+        while (packDedup[h])
+        {
+            u16 other = packDedup[h] - 1;
+            if ((packLength[other] == len) && (memcmp(packStore + packOffset[other], dst, len) == 0)) break;
+            h = (h + 1) & (CART_PACK_DEDUP - 1);
+        }
+
+        packLength[bank] = len;
+        if (packDedup[h])
+        {
+            packOffset[bank] = packOffset[packDedup[h] - 1];
+        }
+        else
+        {
+            packDedup[h] = bank + 1;
+            packOffset[bank] = packUsed;
+            packUsed += len;
+        }
+    }
+
+    fclose(infile);
+
+    cartStreamBanks = numBanks;
+    streamInvert    = inverted;
+    slotsUsed       = 0;
+
+    memset(slotBank, 0xFF, sizeof(slotBank));
+    cartStreaming = 1;
+
+    return cartStreamBanks;
+}
+
+// ------------------------------------------------------------------------------------
+// Done with this cart - forget all of the resident banks and close the image.
+// ------------------------------------------------------------------------------------
+void CartStream_Close(void)
+{
+    if (streamFile) fclose(streamFile);
+    streamFile = NULL;
+    packStore = NULL;
+    cartStreaming = 0;
+    memset(cartStreamBank, 0x00, sizeof(cartStreamBank));
+}
+
+// ------------------------------------------------------------------------------------
+// How much of the cart buffer the streamed banks use (the rest is free for SAMS).
+// ------------------------------------------------------------------------------------
+u32 CartStream_Footprint(void)
+{
+    return ((u32)streamSlots * 0x2000) + packUsed;
+}
+
+// ------------------------------------------------------------------------------------
+// Pick a slot for a bank: a fresh one if there are any left, otherwise the least
+// recently used one. Never the slot the CPU is running from or the one we just filled.
+// ------------------------------------------------------------------------------------
+static u16 CartStream_Victim(u16 keep)
+{
+    if (slotsUsed < streamSlots) return slotsUsed++;
+
+    u16 victim = NO_BANK;
+    u32 oldest = 0;
+    for (u16 slot=0; slot < streamSlots; slot++)
+    {
+        if ((slot == keep) || ((MemCART + (slot * 0x2000)) == tms9900.cartBankPtr)) continue;
+        u32 age = cartStreamClock - cartStreamStamp[slot];
+        if ((victim == NO_BANK) || (age > oldest))
+        {
+            victim = slot;
+            oldest = age;
+        }
+    }
+    return victim;
+}
+
+// ------------------------------------------------------------------------------------
+// Bring one bank into a slot - either decompressed from the store or read from the
+// image file. Returns the slot it went into.
+// ------------------------------------------------------------------------------------
+static u16 CartStream_Load(u16 bank, u16 keep)
+{
+    u16 slot = CartStream_Victim(keep);
+    u8 *ptr = MemCART + (slot * 0x2000);
+
+    if (slotBank[slot] != NO_BANK) cartStreamBank[slotBank[slot]] = NULL;   // Evict whatever was there
+
+    if (packStore)
+    {
+        if (packLength[bank] == 0x2000) memcpy(ptr, packStore + packOffset[bank], 0x2000);
+        else LZ_Unpack(packStore + packOffset[bank], ptr);
+    }
+    else
+    {
+        u16 fileBank = streamInvert ? (cartStreamBanks - 1 - bank) : bank;
+        fseek(streamFile, (u32)fileBank * 0x2000, SEEK_SET);
+        size_t numRead = fread(ptr, 1, 0x2000, streamFile);
+        if (numRead < 0x2000) memset(ptr + numRead, 0xFF, 0x2000 - numRead);   // Last bank of an image that isn't a multiple of 8K (reads as an empty slot)
+    }
+
+    slotBank[slot] = bank;
+    cartStreamBank[bank] = ptr;
+    cartStreamStamp[slot] = cartStreamClock;
+
+    return slot;
+}
+
+// ------------------------------------------------------------------------------------
+// The CPU has switched to a bank that isn't resident. When streaming we also read the
+// banks that follow it in the image - the file is already positioned there so they
+// are nearly free and games tend to use banks that sit near each other. Compressed
+// banks are quick enough to unpack that we just do the one we need.
+// ------------------------------------------------------------------------------------
+u8 *CartStream_Fault(u16 bank)
+{
+    u16 slot = CartStream_Load(bank, NO_BANK);
+
+    for (u8 i=1; (i <= CART_STREAM_PREFETCH) && !packStore; i++)
+    {
+        u16 next = streamInvert ? (bank - i) : (bank + i);     // The next bank in file order
+        if (next >= cartStreamBanks) break;
+        if (cartStreamBank[next]) continue;
+        CartStream_Load(next, slot);
+    }
+
+    cartStreamStamp[slot] = ++cartStreamClock;  // The bank we actually wanted is the most recently used (the prefetched ones are older)
+
+    return cartStreamBank[bank];
+}
+
+// End of file
@@ -0,0 +1,61 @@
+// =====================================================================================
+// Copyright (c) 2023-2026 Dave Bernazzani (wavemotion-dave)
+//
+// Copying and distribution of this emulator, its source code and associated
+// readme files, with or without modification, are permitted in any medium without
+// royalty provided this copyright notice is used and wavemotion-dave is thanked profusely.
+//
+// The DS994a emulator is offered as-is, without any warranty.
+//
+// Please see the README.md file as it contains much useful info.
+// =====================================================================================
+#ifndef _CARTSTREAM_H_
+#define _CARTSTREAM_H_
+
+#include <nds.h>
+#include "DS99.h"
+
+#define CART_STREAM_MAX_BANKS   4096                // 32MB of 8K banks - the most the >6000 bank switch scheme can address
+#define CART_STREAM_CACHE_DSI   (2 * 1024 * 1024)   // On the DSi a streamed cart keeps 2MB of banks resident (the rest of the cart buffer goes to SAMS)
+#define CART_STREAM_PREFETCH    2                   // How many banks following a faulted bank to read while the file is already there
+
+#define CART_PACK_SLOTS_DSI     32                  // Decompressed banks kept resident when the cart is held compressed (DSi)
+#define CART_PACK_SLOTS_DS      8                   // Decompressed banks kept resident when the cart is held compressed (DS-Lite/Phat)
+#define CART_PACK_DEDUP         8192                // Size of the hash table used to find identical banks (must be a power of 2)
+#define LZ_HASH_BITS            12                  // LZ match finder hash table is 4K entries
+#define LZ_MIN_MATCH            4                   // Shortest match worth encoding
+
+extern u8   cartStreaming;
+extern u8  *cartStreamBank[CART_STREAM_MAX_BANKS];
+extern u32  cartStreamStamp[];
+extern u32  cartStreamClock;
+extern u16  cartStreamBanks;
+
+extern u32  CartStream_Limit(void);
+extern u8   CartStream_Wanted(u32 fileSize);
+extern u16  CartStream_Open(const char *filename, u32 fileSize, u8 inverted);
+extern u16  CartStream_Pack(const char *filename, u32 fileSize, u8 inverted);
+extern void CartStream_Close(void);
+extern u8  *CartStream_Fault(u16 bank);
+extern u32  CartStream_Footprint(void);
+
+// ----------------------------------------------------------------------------------------
+// Where is this cart bank in memory? Resident banks are just a table lookup (and a bump of
+// the slot's LRU stamp) - anything else gets read in from the cart image file. The bank
+// mask rounds up to a power of two so banks past the end of the image mirror the start.
+// ----------------------------------------------------------------------------------------
+inline __attribute__((always_inline)) u8 *CartStream_Bank(u16 bank)
+{
+    if (bank >= cartStreamBanks) bank %= cartStreamBanks;
+    u8 *ptr = cartStreamBank[bank];
+    if (ptr)
+    {
+        cartStreamStamp[(ptr - MemCART) >> 13] = ++cartStreamClock;
+        return ptr;
+    }
+    return CartStream_Fault(bank);
+}
+
+#endif // _CARTSTREAM_H_
+
+// End of file
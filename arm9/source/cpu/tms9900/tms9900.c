@@ -26,9 +26,11 @@
 #include "tms9900.h"
 #include "../../DS99.h"
 #include "../../SAMS.h"
+#include "../../cartstream.h"
 #include "../../disk.h"
 #include "../../pcode.h"
 #include "../../speech.h"
+#include "../../scheduler.h"
 #include "../../DS99_utils.h"
 #include "../tms9918a/tms9918a.h"
 #include "../sn76496/SN76496.h"
@@ -68,13 +70,39 @@ u8      MemGROM[0x10000];           // 64K of GROM Space (the lower 24K will con
 // ----------------------------------------------------------------------------------------------
 u8      MemType[0x10000>>4] __attribute__((section(".dtcm")));
 
+// ----------------------------------------------------------------------------------------------
+// The memory page table - a direct pointer to the host memory behind each 256 byte page of the
+// CPU address space (one for reads and one for writes). NULL means the page needs the full
+// MemType[] handling. See TMS9900_MapPages() below for how these get filled in.
+// ----------------------------------------------------------------------------------------------
+u8     *MemPageRead[256]  __attribute__((section(".dtcm")));
+u8     *MemPageWrite[256] __attribute__((section(".dtcm")));
+u32     cartPages = 0;                                  // Bit mask of the 32 pages at >6000 that are mapped to the banked cart ROM
+
+#ifdef TMS9900_MEM_STATS
+// ----------------------------------------------------------------------------------------------
+// Memory access counts for the instrumentation build - [read/write/fetch][class or page]. These
+// are only looked at from the debugger so they can sit out in main memory.
+// ----------------------------------------------------------------------------------------------
+u32 memStatsType[3][MF_UNUSED+1];
+u32 memStatsPage[3][256];
+
+const char *memStatsTypeName[MF_UNUSED+1] =
+{
+    "MEM16", "RAM8", "SOUND", "SPEECH", "CART", "CARTNB", "VDP-R", "VDP-W", "GROM-R", "GROM-W", "SAMS",
+    "SAMS8", "MBX", "PERIF", "DISK", "PCODE", "RES2", "RES3", "RES4", "RES5", "RES6", "UNUSED"
+};
+#endif
+
+// Only the console ROM and the scratchpad RAM are on the 16-bit bus - everything else mapped direct pays the 8-bit penalty
+#define PAGE_PENALTY(address)   ((((address) & 0xE000) && (((address) & 0xFC00) != 0x8000)) ? 4:0)
+
 u8     *MemCART  __attribute__((section(".dtcm")));     // Cart C/D/8/9 memory up to 8MB/512K (DSi vs DS) banked at >6000
 u32     MAX_CART_SIZE = (512*1024);                     // Allow carts up to 512K in size (DSi will bump this to 8MB)
 
 TMS9900 tms9900  __attribute__((section(".dtcm")));  // Put the entire TMS9900 set of registers and helper vars into fast .DTCM RAM on the DS
 
-#define OpcodeLookup            ((u16*)0x06820000)   // We use 128K of semi-fast VDP memory to help with the OpcodeLookup[] lookup table (normally VRAM_B)
-#define CompareZeroLookup16     ((u16*)0x06860000)   // We use 128K of semi-fast VDP memory to help with the CompareZeroLookup16[] lookup table (normally VRAM_D)
+#define DecodeCache             ((u32*)0x06880000)   // We use 64K of semi-fast VDP memory for the pre-decoded instruction cache (normally VRAM_E)
 
 #define AddCycleCount(x) (tms9900.cycles += (x))     // Our main way of bumping up the cycle counts during execution - each opcode handles their own timing increments
 
@@ -90,7 +118,7 @@ u32 idle_counter = 0;   // Only used for debug purposes... so it doesn't need to
 extern SN76496 snti99;
 
 // Supporting banking up to 8MB (1024 x 8KB = 8192KB) even though our cart buffer might be smaller
-u16 BankMasks[1024];
+u16 BankMasks[CART_STREAM_MAX_BANKS];
 
 // Pre-fill the parity table for fast look-up based on Classic99 'black magic'
 u16 ParityTable[256]     __attribute__((section(".dtcm")));
@@ -102,11 +130,105 @@ u16 ParityTable[256]     __attribute__((section(".dtcm")));
 // ---------------------------------------------------------------------------------
 u16 CompareZeroLookup8[256] __attribute__((section(".dtcm")));
 
+// ---------------------------------------------------------------------------------------------
+// The compact opcode decoder. The TMS9900 decodes on the upper 10 bits of the opcode except for
+// the >0200 to >03FF group (LI, AI, ... LREX) which needs bit 5 as well. Those 1K slots are
+// marked with OPCODE_DECODE_SUB and the 16 entries for that group follow the main table. At
+// just over 1K this fits nicely into the fast .DTCM data memory.
+// ---------------------------------------------------------------------------------------------
+#define OPCODE_DECODE_MAIN      1024
+#define OPCODE_DECODE_SUB       op_max
+
+u8 OpcodeDecode[OPCODE_DECODE_MAIN + 16] __attribute__((section(".dtcm")));
+
+static inline __attribute__((always_inline)) u8 DecodeOpcode(u16 opcode)
+{
+    u8 op8 = OpcodeDecode[opcode >> 6];
+    if (op8 == OPCODE_DECODE_SUB) op8 = OpcodeDecode[OPCODE_DECODE_MAIN + ((opcode >> 5) & 0x0F)];
+    return op8;
+}
+
+LazyStatus lazyST __attribute__((section(".dtcm"))) = {0, 0, 0};
+
+// ---------------------------------------------------------------------------------------------
+// The Word compare-to-zero status bits (L> A> EQ) computed without branches or table lookups.
+// This used to be a 64K entry table in VRAM but a handful of ALU instructions beats a trip out
+// to the slow VRAM bus - and it frees up that 128K of VRAM (and no rebuild after screenshots).
+// ---------------------------------------------------------------------------------------------
+static inline __attribute__((always_inline)) u16 CompareZero16(u16 v)
+{
+    u32 nz  = ((u32)v + 0xFFFF) >> 16;      // 1 if non-zero (only zero doesn't carry into bit 16)
+    u32 pos = nz & ~((u32)v >> 15);         // 1 if non-zero and the sign bit is clear
+    return (nz << 15) | (pos << 14) | ((nz ^ 1) << 13);
+}
+
+// ---------------------------------------------------------------------------------------------
+// The L> A> EQ bits for a compare of 'a' against 'b'. A compare-to-zero is just b=0 and bytes
+// are compared in the upper half of the word so the same signed/unsigned tests work for both.
+// ---------------------------------------------------------------------------------------------
+static inline __attribute__((always_inline)) u16 StatusCompare(u16 a, u16 b)
+{
+    return ((a > b) ? ST_LGT:0) | (((s16)a > (s16)b) ? ST_AGT:0) | ((a == b) ? ST_EQ:0);
+}
+
+// ---------------------------------------------------------------------------------------------
+// Bring the L> A> EQ bits in tms9900.ST up to date from the last recorded result (if needed).
+// Anything outside the CPU core that looks at tms9900.ST should call this first.
+// ---------------------------------------------------------------------------------------------
+void TMS9900_SyncStatus(void)
+{
+    if (lazyST.pending)
+    {
+        tms9900.ST = STATUS_CLEAR_LAE | StatusCompare(lazyST.result, lazyST.operand);
+        lazyST.pending = 0;
+    }
+}
+
+// -------------------------------------------------------------------------------------------------------------
+// How the opcode handlers set the L> A> EQ (and for bytes, the P) status bits. The 'clr' bits are the other
+// status bits the instruction will compute itself (C and/or OV) and so must be cleared first. With lazy flags
+// only the C/OV/P bits are touched in tms9900.ST and the result is recorded for later... the COND_xxx tests
+// for the conditional jumps then work directly on the recorded result whenever it's pending.
+// -------------------------------------------------------------------------------------------------------------
+#ifdef TMS9900_LAZY_FLAGS
+#define STATUS_LAE16(v, clr)    {tms9900.ST &= ~(clr); lazyST.result = (v); lazyST.operand = 0; lazyST.pending = 1;}
+#define STATUS_LAEP8(v, clr)    {tms9900.ST = (tms9900.ST & ~(ST_OP | (clr))) | ParityTable[(u8)(v)]; lazyST.result = (v)<<8; lazyST.operand = 0; lazyST.pending = 1;}
+#define STATUS_COMPARE(a, b)    {lazyST.result = (a); lazyST.operand = (b); lazyST.pending = 1;}
+#define STATUS_SYNC()           if (lazyST.pending) TMS9900_SyncStatus()
+#define STATUS_LOAD(st)         {tms9900.ST = (st); lazyST.pending = 0;}
+
+#define LAZY_U(op)              (lazyST.result op lazyST.operand)
+#define LAZY_S(op)              ((s16)lazyST.result op (s16)lazyST.operand)
+#define COND_JLT                (lazyST.pending ? LAZY_S(<)  : !(tms9900.ST & (ST_AGT | ST_EQ)))
+#define COND_JLE                (lazyST.pending ? LAZY_U(<=) : ((!(tms9900.ST & ST_LGT)) | (tms9900.ST & ST_EQ)))
+#define COND_JEQ                (lazyST.pending ? LAZY_U(==) : (tms9900.ST & ST_EQ))
+#define COND_JHE                (lazyST.pending ? LAZY_U(>=) : (tms9900.ST & (ST_LGT | ST_EQ)))
+#define COND_JGT                (lazyST.pending ? LAZY_S(>)  : (tms9900.ST & ST_AGT))
+#define COND_JNE                (lazyST.pending ? LAZY_U(!=) : !(tms9900.ST & ST_EQ))
+#define COND_JL                 (lazyST.pending ? LAZY_U(<)  : !(tms9900.ST & (ST_LGT | ST_EQ)))
+#define COND_JH                 (lazyST.pending ? LAZY_U(>)  : ((tms9900.ST & ST_LGT) && !(tms9900.ST & ST_EQ)))
+#else
+#define STATUS_LAE16(v, clr)    tms9900.ST = (tms9900.ST & ~(ST_LGT | ST_AGT | ST_EQ | (clr))) | CompareZero16(v)
+#define STATUS_LAEP8(v, clr)    tms9900.ST = (tms9900.ST & ~(ST_LGT | ST_AGT | ST_EQ | ST_OP | (clr))) | CompareZeroLookup8[(u8)(v)]
+#define STATUS_COMPARE(a, b)    tms9900.ST = STATUS_CLEAR_LAE | StatusCompare((a), (b))
+#define STATUS_SYNC()
+#define STATUS_LOAD(st)         tms9900.ST = (st)
+
+#define COND_JLT                !(tms9900.ST & (ST_AGT | ST_EQ))
+#define COND_JLE                ((!(tms9900.ST & ST_LGT)) | (tms9900.ST & ST_EQ))
+#define COND_JEQ                (tms9900.ST & ST_EQ)
+#define COND_JHE                (tms9900.ST & (ST_LGT | ST_EQ))
+#define COND_JGT                (tms9900.ST & ST_AGT)
+#define COND_JNE                !(tms9900.ST & ST_EQ)
+#define COND_JL                 !(tms9900.ST & (ST_LGT | ST_EQ))
+#define COND_JH                 ((tms9900.ST & ST_LGT) && !(tms9900.ST & ST_EQ))
+#endif
+
 
 ////////////////////////////////////////////////////////////////////////////
 // CPU Opcode 02 helper function
 ////////////////////////////////////////////////////////////////////////////
-void opcode02(u16 in)
+u8 opcode02(u16 in)
 {
     u16 x;
 
@@ -114,22 +236,22 @@ void opcode02(u16 in)
 
     switch(x)
     {
-    case 0: OpcodeLookup[in]=op_li;   break;
-    case 2: OpcodeLookup[in]=op_ai;   break;
-    case 4: OpcodeLookup[in]=op_andi; break;
-    case 6: OpcodeLookup[in]=op_ori;  break;
-    case 8: OpcodeLookup[in]=op_ci;   break;
-    case 10:OpcodeLookup[in]=op_stwp; break;
-    case 12:OpcodeLookup[in]=op_stst; break;
-    case 14:OpcodeLookup[in]=op_lwpi; break;
-    default: OpcodeLookup[in]=op_bad; break;
+    case 0: return op_li;
+    case 2: return op_ai;
+    case 4: return op_andi;
+    case 6: return op_ori;
+    case 8: return op_ci;
+    case 10:return op_stwp;
+    case 12:return op_stst;
+    case 14:return op_lwpi;
+    default: return op_bad;
     }
 }
 
 ////////////////////////////////////////////////////////////////////////////
 // CPU Opcode 03 helper function
 ////////////////////////////////////////////////////////////////////////////
-void opcode03(u16 in)
+u8 opcode03(u16 in)
 {
     u16 x;
 
@@ -137,21 +259,21 @@ void opcode03(u16 in)
 
     switch(x)
     {
-    case 0: OpcodeLookup[in]=op_limi; break;
-    case 4: OpcodeLookup[in]=op_idle; break;
-    case 6: OpcodeLookup[in]=op_rset; break;
-    case 8: OpcodeLookup[in]=op_rtwp; break;
-    case 10:OpcodeLookup[in]=op_ckon; break;
-    case 12:OpcodeLookup[in]=op_ckof; break;
-    case 14:OpcodeLookup[in]=op_lrex; break;
-    default: OpcodeLookup[in]=op_bad; break;
+    case 0: return op_limi;
+    case 4: return op_idle;
+    case 6: return op_rset;
+    case 8: return op_rtwp;
+    case 10:return op_ckon;
+    case 12:return op_ckof;
+    case 14:return op_lrex;
+    default: return op_bad;
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////
 // CPU Opcode 04 helper function
 ///////////////////////////////////////////////////////////////////////////
-void opcode04(u16 in)
+u8 opcode04(u16 in)
 {
     u16 x;
 
@@ -159,18 +281,18 @@ void opcode04(u16 in)
 
     switch(x)
     {
-    case 0: OpcodeLookup[in]=op_blwp; break;
-    case 4: OpcodeLookup[in]=op_b;    break;
-    case 8: OpcodeLookup[in]=op_x;    break;
-    case 12:OpcodeLookup[in]=op_clr;  break;
-    default: OpcodeLookup[in]=op_bad; break;
+    case 0: return op_blwp;
+    case 4: return op_b;
+    case 8: return op_x;
+    case 12:return op_clr;
+    default: return op_bad;
     }
 }
 
 //////////////////////////////////////////////////////////////////////////
 // CPU Opcode 05 helper function
 //////////////////////////////////////////////////////////////////////////
-void opcode05(u16 in)
+u8 opcode05(u16 in)
 {
     u16 x;
 
@@ -178,18 +300,18 @@ void opcode05(u16 in)
 
     switch(x)
     {
-    case 0: OpcodeLookup[in]=op_neg;  break;
-    case 4: OpcodeLookup[in]=op_inv;  break;
-    case 8: OpcodeLookup[in]=op_inc;  break;
-    case 12:OpcodeLookup[in]=op_inct; break;
-    default: OpcodeLookup[in]=op_bad; break;
+    case 0: return op_neg;
+    case 4: return op_inv;
+    case 8: return op_inc;
+    case 12:return op_inct;
+    default: return op_bad;
     }
 }
 
 ////////////////////////////////////////////////////////////////////////
 // CPU Opcode 06 helper function
 ////////////////////////////////////////////////////////////////////////
-void opcode06(u16 in)
+u8 opcode06(u16 in)
 {
     u16 x;
 
@@ -197,18 +319,18 @@ void opcode06(u16 in)
 
     switch(x)
     {
-    case 0: OpcodeLookup[in]=op_dec;  break;
-    case 4: OpcodeLookup[in]=op_dect; break;
-    case 8: OpcodeLookup[in]=op_bl;   break;
-    case 12:OpcodeLookup[in]=op_swpb; break;
-    default: OpcodeLookup[in]=op_bad; break;
+    case 0: return op_dec;
+    case 4: return op_dect;
+    case 8: return op_bl;
+    case 12:return op_swpb;
+    default: return op_bad;
     }
 }
 
 ////////////////////////////////////////////////////////////////////////
 // CPU Opcode 07 helper function
 ////////////////////////////////////////////////////////////////////////
-void opcode07(u16 in)
+u8 opcode07(u16 in)
 {
     u16 x;
 
@@ -216,16 +338,16 @@ void opcode07(u16 in)
 
     switch(x)
     {
-    case 0: OpcodeLookup[in]=op_seto; break;
-    case 4: OpcodeLookup[in]=op_abs;  break;
-    default: OpcodeLookup[in]=op_bad; break;
+    case 0: return op_seto;
+    case 4: return op_abs;
+    default: return op_bad;
     }
 }
 
 ////////////////////////////////////////////////////////////////////////
 // CPU Opcode 1 helper function
 ////////////////////////////////////////////////////////////////////////
-void opcode1(u16 in)
+u8 opcode1(u16 in)
 {
     u16 x;
 
@@ -233,30 +355,30 @@ void opcode1(u16 in)
 
     switch(x)
     {
-    case 0: OpcodeLookup[in]=op_jmp; break;
-    case 1: OpcodeLookup[in]=op_jlt; break;
-    case 2: OpcodeLookup[in]=op_jle; break;
-    case 3: OpcodeLookup[in]=op_jeq; break;
-    case 4: OpcodeLookup[in]=op_jhe; break;
-    case 5: OpcodeLookup[in]=op_jgt; break;
-    case 6: OpcodeLookup[in]=op_jne; break;
-    case 7: OpcodeLookup[in]=op_jnc; break;
-    case 8: OpcodeLookup[in]=op_joc; break;
-    case 9: OpcodeLookup[in]=op_jno; break;
-    case 10:OpcodeLookup[in]=op_jl;  break;
-    case 11:OpcodeLookup[in]=op_jh;  break;
-    case 12:OpcodeLookup[in]=op_jop; break;
-    case 13:OpcodeLookup[in]=op_sbo; break;
-    case 14:OpcodeLookup[in]=op_sbz; break;
-    case 15:OpcodeLookup[in]=op_tb;  break;
-    default: OpcodeLookup[in]=op_bad;break;
+    case 0: return op_jmp;
+    case 1: return op_jlt;
+    case 2: return op_jle;
+    case 3: return op_jeq;
+    case 4: return op_jhe;
+    case 5: return op_jgt;
+    case 6: return op_jne;
+    case 7: return op_jnc;
+    case 8: return op_joc;
+    case 9: return op_jno;
+    case 10:return op_jl;
+    case 11:return op_jh;
+    case 12:return op_jop;
+    case 13:return op_sbo;
+    case 14:return op_sbz;
+    case 15:return op_tb;
+    default: return op_bad;
     }
 }
 
 ////////////////////////////////////////////////////////////////////////
 // CPU Opcode 2 helper function
 ////////////////////////////////////////////////////////////////////////
-void opcode2(u16 in)
+u8 opcode2(u16 in)
 {
     u16 x;
 
@@ -264,18 +386,18 @@ void opcode2(u16 in)
 
     switch(x)
     {
-    case 0: OpcodeLookup[in]=op_coc; break;
-    case 4: OpcodeLookup[in]=op_czc; break;
-    case 8: OpcodeLookup[in]=op_xor; break;
-    case 12:OpcodeLookup[in]=op_xop; break;
-    default: OpcodeLookup[in]=op_bad;break;
+    case 0: return op_coc;
+    case 4: return op_czc;
+    case 8: return op_xor;
+    case 12:return op_xop;
+    default: return op_bad;
     }
 }
 
 ////////////////////////////////////////////////////////////////////////
 // CPU Opcode 3 helper function
 ////////////////////////////////////////////////////////////////////////
-void opcode3(u16 in)
+u8 opcode3(u16 in)
 {
     u16 x;
 
@@ -283,11 +405,11 @@ void opcode3(u16 in)
 
     switch(x)
     {
-    case 0: OpcodeLookup[in]=op_ldcr; break;
-    case 4: OpcodeLookup[in]=op_stcr; break;
-    case 8: OpcodeLookup[in]=op_mpy;  break;
-    case 12:OpcodeLookup[in]=op_div;  break;
-    default: OpcodeLookup[in]=op_bad; break;
+    case 0: return op_ldcr;
+    case 4: return op_stcr;
+    case 8: return op_mpy;
+    case 12:return op_div;
+    default: return op_bad;
     }
 }
 
@@ -295,7 +417,7 @@ void opcode3(u16 in)
 ///////////////////////////////////////////////////////////////////////////
 // CPU Opcode 0 helper function
 ///////////////////////////////////////////////////////////////////////////
-void opcode0(u16 in)
+u8 opcode0(u16 in)
 {
     u16 x;
 
@@ -303,58 +425,76 @@ void opcode0(u16 in)
 
     switch(x)
     {
-    case 2:  opcode02(in);       break;
-    case 3:  opcode03(in);       break;
-    case 4:  opcode04(in);       break;
-    case 5:  opcode05(in);       break;
-    case 6:  opcode06(in);       break;
-    case 7:  opcode07(in);       break;
-    case 8:  OpcodeLookup[in]=op_sra; break;
-    case 9:  OpcodeLookup[in]=op_srl; break;
-    case 10: OpcodeLookup[in]=op_sla; break;
-    case 11: OpcodeLookup[in]=op_src; break;
-    default: OpcodeLookup[in]=op_bad; break;
+    case 2:  return opcode02(in);
+    case 3:  return opcode03(in);
+    case 4:  return opcode04(in);
+    case 5:  return opcode05(in);
+    case 6:  return opcode06(in);
+    case 7:  return opcode07(in);
+    case 8:  return op_sra;
+    case 9:  return op_srl;
+    case 10: return op_sla;
+    case 11: return op_src;
+    default: return op_bad;
+    }
+}
+////////////////////////////////////////////////////////////////////////
+// Decode any TMS9900 16-bit Opcode into the _OPCODES enum the long way.
+////////////////////////////////////////////////////////////////////////
+u8 opcodeDecode(u16 in)
+{
+    u16 x;
+
+    x=(in&0xf000)>>12;
+
+    switch(x)
+    {
+    case 0: return opcode0(in);
+    case 1: return opcode1(in);
+    case 2: return opcode2(in);
+    case 3: return opcode3(in);
+    case 4: return op_szc;
+    case 5: return op_szcb;
+    case 6: return op_s;
+    case 7: return op_sb;
+    case 8: return op_c;
+    case 9: return op_cb;
+    case 10:return op_a;
+    case 11:return op_ab;
+    case 12:return op_mov;
+    case 13:return op_movb;
+    case 14:return op_soc;
+    case 15:return op_socb;
+    default: return op_bad;
     }
 }
+
 ////////////////////////////////////////////////////////////////////////
 // Fill the CPU Opcode Address table
 // WARNING: called more than once, so be careful about anything you can't do twice!
 ////////////////////////////////////////////////////////////////////////
 void TMS9900_buildopcodes(void)
 {
-    u16 in,x,z;
+    u16 z;
     unsigned int i;
 
     // -----------------------------------------------------
     // Build the streamined Opcode table... this will let
     // us take any TMS9900 16-bit Opcode and turn it into
     // a simple enum lookup for relatively blazing speed.
+    // Only the upper 10 bits matter except for >0200 to
+    // >03FF which needs one more bit - those get the extra
+    // 16 entries at the end of the table.
     // -----------------------------------------------------
-    for (i=0; i<0x10000; i++)
+    for (i=0; i<OPCODE_DECODE_MAIN; i++)
     {
-        in=(u16)i;
+        OpcodeDecode[i] = opcodeDecode(i<<6);
+    }
 
-        x=(in&0xf000)>>12;
-        switch(x)
-        {
-        case 0: opcode0(in);             break;
-        case 1: opcode1(in);             break;
-        case 2: opcode2(in);             break;
-        case 3: opcode3(in);             break;
-        case 4: OpcodeLookup[in]=op_szc; break;
-        case 5: OpcodeLookup[in]=op_szcb;break;
-        case 6: OpcodeLookup[in]=op_s;   break;
-        case 7: OpcodeLookup[in]=op_sb;  break;
-        case 8: OpcodeLookup[in]=op_c;   break;
-        case 9: OpcodeLookup[in]=op_cb;  break;
-        case 10:OpcodeLookup[in]=op_a;   break;
-        case 11:OpcodeLookup[in]=op_ab;  break;
-        case 12:OpcodeLookup[in]=op_mov; break;
-        case 13:OpcodeLookup[in]=op_movb;break;
-        case 14:OpcodeLookup[in]=op_soc; break;
-        case 15:OpcodeLookup[in]=op_socb;break;
-        default: OpcodeLookup[in]=op_bad;break;
-        }
+    for (i=0; i<16; i++)
+    {
+        OpcodeDecode[(0x0200>>6) + (i>>1)] = OPCODE_DECODE_SUB;
+        OpcodeDecode[OPCODE_DECODE_MAIN + i] = opcodeDecode(0x0200 + (i<<5));
     }
 
     // ------------------------------------------
@@ -367,19 +507,6 @@ void TMS9900_buildopcodes(void)
         ParityTable[i] = (z&1) ? ST_OP : 0;
     }
 
-    // build the Word status lookup table. This handles Logical, Arithmetic and Equal and
-    // the other bits will be handled manually on a per-instruction basis...
-    for (i=0; i<0x10000; i++)
-    {
-        CompareZeroLookup16[i]=0x0000;
-        // LGT
-        if (i>0) CompareZeroLookup16[i]|=ST_LGT;
-        // AGT
-        if ((i>0)&&(i<0x8000)) CompareZeroLookup16[i]|=ST_AGT;
-        // EQ
-        if (i==0) CompareZeroLookup16[i]|=ST_EQ;
-    }
-
     // And now the Byte status lookup table. This handles Logical, Arithmetic and Equal plus Parity
     // and the other bits will be handled manually on a per-instruction basis...
     for (i=0; i<256; i++)
@@ -416,9 +543,9 @@ void TMS9900_Reset(void)
 
     // ----------------------------------------------------------------------
     // Fill in the BankMasks[] for any number of possible banks up to the
-    // full limit of 1024 banks (8MB of Cart Space!!)
+    // full limit of 4096 banks (32MB of Cart Space - only when streaming!!)
     // ----------------------------------------------------------------------
-    for (u16 numBanks=1; numBanks<=1024; numBanks++)
+    for (u16 numBanks=1; numBanks<=CART_STREAM_MAX_BANKS; numBanks++)
     {
         if      (numBanks <= 1)    BankMasks[numBanks-1] = 0x0000;  // No banking
         else if (numBanks <= 2)    BankMasks[numBanks-1] = 0x0001;
@@ -430,7 +557,9 @@ void TMS9900_Reset(void)
         else if (numBanks <= 128)  BankMasks[numBanks-1] = 0x007F;
         else if (numBanks <= 256)  BankMasks[numBanks-1] = 0x00FF;
         else if (numBanks <= 512)  BankMasks[numBanks-1] = 0x01FF;
-        else                       BankMasks[numBanks-1] = 0x03FF;
+        else if (numBanks <= 1024) BankMasks[numBanks-1] = 0x03FF;
+        else if (numBanks <= 2048) BankMasks[numBanks-1] = 0x07FF;
+        else                       BankMasks[numBanks-1] = 0x0FFF;
     }
 
     // ---------------------------------------------------------------------------
@@ -521,9 +650,15 @@ void TMS9900_Reset(void)
     // ---------------------------------------------------------
     // Now setup for all the CART and Console roms ...
     // ---------------------------------------------------------
-    memset(MemCART,         0xFF,(512*1024));       // The cart is not inserted to start... We map larger than this, but don't waste time clearing more than 512K
+    if (cartPreloaded < (512*1024))                 // The cart is not inserted to start (other than whatever was read in along with the CRC)...
+    {
+        memset(MemCART+cartPreloaded, 0xFF, (512*1024) - cartPreloaded);   // We map larger than this, but don't waste time clearing more than 512K
+    }
     memset(MemCPU,          0xFF, 0x10000);         // Set all of memory to 0xFF (nothing mapped until proven otherwise)
     memset(MemGROM,         0xFF, 0x10000);         // Set all of GROM memory to 0xFF (nothing mapped until proven otherwise)
+#ifdef TMS9900_MEM_STATS
+    MemStats_Clear();                               // Access counts start fresh with each game (or reset)
+#endif
 
     // ---------------------------------------------------------------------------
     // By default we clear memory but if this game is marked as 'RANDOMIZE' we
@@ -531,14 +666,10 @@ void TMS9900_Reset(void)
     // ---------------------------------------------------------------------------
     if (myConfig.memWipe == 1) // RANDOMize memory if asked for
     {
-        for (u16 addr = 0x8000; addr < 0x8100; addr++)
+        for (u16 addr = 0x8300; addr < 0x8400; addr++)
         {
-            // Same random value shows up in all mirrors....
-            u8 val = rand() & 0xFF;
-            MemCPU[addr | 0x000] = (val);
-            MemCPU[addr | 0x100] = (val);
-            MemCPU[addr | 0x200] = (val);
-            MemCPU[addr | 0x300] = (val);
+            // The mirrors are all folded onto >8300 so this is the only copy
+            MemCPU[addr] = rand() & 0xFF;
         }
     }
     else
@@ -565,6 +696,12 @@ void TMS9900_Reset(void)
 
     idle_counter = 0;
 
+    // Nothing from a previous cart should be left in the decoded instruction cache
+    TMS9900_FlushDecodeCache();
+
+    // Start the event schedule over from the first scanline
+    Scheduler_Reset();
+
     // Reset the TMS9901 peripheral IO chip
     TMS9901_Reset();
 }
@@ -574,10 +711,13 @@ void TMS9900_Reset(void)
 // -----------------------------------------------------------------------------------------------
 void TMS9900_Kickoff(void)
 {
+    // The memory map is fully set up by now (cart type, DSRs, SAMS) so build the page table from it
+    TMS9900_MapPages(0x0000, 0x10000);
+
     // And away we go!
     tms9900.WP = MemoryRead16(0) & 0xFFFE;  // Initial WP is from the first word address in memory
     tms9900.PC = MemoryRead16(2) & 0xFFFE;  // Initial PC is from the second word address in memory
-    tms9900.ST = 0x3cf0;                    // bulWIP uses this - probably doesn't matter... but smart guys know stuff...
+    STATUS_LOAD(0x3cf0);                    // bulWIP uses this - probably doesn't matter... but smart guys know stuff...
 }
 
 // -----------------------------------------------------------------------------------------------
@@ -690,6 +830,105 @@ void WriteGROM(u8 data)
     // Does nothing... should we chew up cycles?
 }
 
+// ---------------------------------------------------------------------------------------------------------------------------
+// The memory page table. Rather than looking up the MemType[] and switching on it for every memory access, we keep a
+// direct pointer to the host memory that backs each 256 byte page of the CPU address space - one for reads and one for
+// writes. Console ROM, scratchpad, expanded RAM, the DSR ROM space, cart ROM (in the current bank) and SAMS (in the
+// currently mapped bank) all resolve to a single indexed load. A NULL entry means the page holds something that needs
+// special handling (memory mapped devices, bank switch registers, console ROM writes or a mix of memory types within the
+// page) and the access goes through the MemType[] switch just as before. Anything that changes the memory map patches
+// the affected entries: bank switching calls TMS9900_MapCart(), SAMS paging calls TMS9900_MapSAMS() and anything that
+// changes the MemType[] (DSR mapping, SAMS registers, p-code) calls TMS9900_MapPages() for the range it touched.
+// ---------------------------------------------------------------------------------------------------------------------------
+void TMS9900_MapPages(u16 address, u32 size)
+{
+    for (u32 addr = (address & 0xFF00); addr < ((u32)address + size); addr += 0x100)
+    {
+        u8 page = addr >> 8;
+        u8 memType = MemType[addr>>4];
+        u8 *readPtr = NULL;
+        u8 *writePtr = NULL;
+
+        // We can only go direct if the whole page is the same type of memory
+        u8 uniform = 1;
+        for (u8 i=1; i<16; i++)
+        {
+            if (MemType[(addr>>4)+i] != memType) uniform = 0;
+        }
+
+        if (uniform)
+        {
+            switch (memType)
+            {
+                case MF_MEM16:      // Console ROM (writes ignored) or scratchpad - all four mirrors fold onto the one copy at >8300
+                    if (addr & 0x8000) readPtr = writePtr = MemCPU + 0x8300;
+                    else readPtr = MemCPU + addr;
+                    break;
+                case MF_CART_NB:
+                case MF_PERIF:
+                case MF_UNUSED:
+                    readPtr = MemCPU + addr;
+                    break;
+                case MF_RAM8:       // The Super Cart RAM at >6000 is banked just like cart ROM - everything else is plain MemCPU[]
+                    if ((myConfig.cartType == CART_TYPE_SUPERCART) && ((addr & 0xE000) == 0x6000)) readPtr = writePtr = tms9900.cartBankPtr + (addr & 0x1F00);
+                    else readPtr = writePtr = MemCPU + addr;
+                    break;
+                case MF_CART:       // Writes to cart space are bank switches
+                    readPtr = tms9900.cartBankPtr + (addr & 0x1F00);
+                    break;
+                case MF_SAMS8:      // A bank that has never been written is the shared zero page - reads only until it gets its own page
+                    readPtr = theSAMS.memoryPtr[addr>>12] + (addr & 0x0F00);
+                    if (theSAMS.memoryPtr[addr>>12] != SAMS_ZeroPage) writePtr = readPtr;
+                    break;
+                default:            // Memory mapped devices all stay on the slow path
+                    break;
+            }
+        }
+
+        MemPageRead[page]  = readPtr;
+        MemPageWrite[page] = writePtr;
+
+        if ((page & 0xE0) == 0x60)  // Keep track of which cart pages need patching on a bank switch
+        {
+            if (readPtr && (readPtr != (MemCPU + addr))) cartPages |= (1 << (page & 0x1F)); else cartPages &= ~(1 << (page & 0x1F));
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------
+// The cart bank has changed - point the cart pages at the new tms9900.cartBankPtr.
+// The Super Cart RAM pages are writable so those get the write pointer patched too.
+// ------------------------------------------------------------------------------------
+ITCM_CODE void TMS9900_MapCart(void)
+{
+    u32 pages = cartPages;
+    while (pages)
+    {
+        u8 page = __builtin_ctz(pages);
+        MemPageRead[0x60 + page] = tms9900.cartBankPtr + (page << 8);
+        if (MemPageWrite[0x60 + page]) MemPageWrite[0x60 + page] = tms9900.cartBankPtr + (page << 8);
+        pages &= (pages - 1);
+    }
+}
+
+// ------------------------------------------------------------------------------------
+// A SAMS 4K region has been swapped - point its 16 pages at the new bank. An unwritten
+// bank is the shared zero page so writes go the slow way (which allocates the bank).
+// ------------------------------------------------------------------------------------
+void TMS9900_MapSAMS(u8 region)
+{
+    if (MemType[region << 8] != MF_SAMS8) return;   // Only the expanded RAM regions are SAMS mapped
+
+    u8 *ptr = theSAMS.memoryPtr[region];
+    u8 writable = (ptr != SAMS_ZeroPage);
+    for (u8 i=0; i<16; i++)
+    {
+        MemPageRead[(region << 4) + i]  = ptr + (i << 8);
+        MemPageWrite[(region << 4) + i] = writable ? (ptr + (i << 8)) : 0;
+    }
+}
+
+
 // -------------------------------------------------------------------------------------------------------------------------------------------
 // TI carts bank with writes to the ROM area at >6000 and up (e.g. write to >6000 is bank 0, write to >6002 is bank 1, write to >6004 is
 // bank 3,etc). At one time I was using memcpy() to put the bank into the right spot into the MemCPU[] which is GREAT when you want to read
@@ -698,8 +937,8 @@ void WriteGROM(u8 data)
 // which is fast enough to render those games full-speed but does mean our memory reads and PC fetches are a little more complicated...
 //
 // Anyway... the maximum cart size that can be supported by this traditional banking scheme is (8192 / 2 = 4096 banks of 8K or 32MB!).
-// That's huge - larger than all of the available 16MB of RAM on a DSi and way bigger than the 4MB of RAM on a DS-Lite/Phat. We don't
-// support that large but it's okay - 99% of all carts are less than 512K.
+// That's huge - larger than all of the available 16MB of RAM on a DSi and way bigger than the 4MB of RAM on a DS-Lite/Phat. Carts too
+// big to hold in memory are streamed from the image file (see cartstream.c) - only the recently used banks are resident.
 // -------------------------------------------------------------------------------------------------------------------------------------------
 inline __attribute__((always_inline)) void WriteBank(u16 address)
 {
@@ -709,7 +948,9 @@ inline __attribute__((always_inline)) void WriteBank(u16 address)
         u16 bank = (address >> 1);                              // Divide by 2 as we are always looking at bit 1 (not bit 0)
         bank &= tms9900.bankMask;                               // Support up to the maximum bank size using mask (based on file size as read in)
         tms9900.bankOffset = (0x2000 * bank);                   // Memory Reads will now use this offset into the Cart space...
-        tms9900.cartBankPtr = MemCART+tms9900.bankOffset;       // And point to the right place in memory for cart fetches
+        if (cartStreaming) tms9900.cartBankPtr = CartStream_Bank(bank);    // Streamed carts keep their banks wherever there was room
+        else tms9900.cartBankPtr = MemCART+tms9900.bankOffset;  // And point to the right place in memory for cart fetches
+        TMS9900_MapCart();                                      // And patch the page table to match
     }
 }
 
@@ -722,6 +963,7 @@ inline __attribute__((always_inline)) void WriteBankMBX(u8 bank)
     bank &= 0x3;                                            // There are up to 4 cart banks
     tms9900.bankOffset = (bank*0x1000) - 0x1000;            // The -0x1000 offsets by 4K so that the memory fetch works correctly at >7000
     tms9900.cartBankPtr = MemCART+tms9900.bankOffset;       // And point to the right place in memory for cart fetches
+    TMS9900_MapCart();                                      // And patch the page table to match
 }
 
 // ------------------------------------------------------------------------------
@@ -750,6 +992,7 @@ void cart_cru_write(u16 cruAddress, u8 dataBit)
             bank &= tms9900.bankMask;                           // Mask the 8K bank within the size of the ROM
             tms9900.bankOffset = (bank*0x2000);                 // Keep this up to date for SAVE/LOAD state
             tms9900.cartBankPtr = MemCART+tms9900.bankOffset;   // And point to the right place in memory for cart fetches
+            TMS9900_MapCart();                                  // And patch the page table to match
         }
         cart_cru_shadow[cruAddress] = dataBit;
     }
@@ -759,15 +1002,24 @@ void cart_cru_write(u16 cruAddress, u8 dataBit)
         cruAddress &= 0x7;
         if ((cruAddress > 0) && (dataBit != 0)) // Is the bit ON and we are above the base address?
         {
-            u8 bank = (cruAddress-1)/2;                                                 // Grab the new bank number - logic borrowed from MAME
-            memcpy(MemCART+(MAX_CART_SIZE-(super_bank*0x2000)), MemCPU+0x6000, 0x2000); // Copy out the working 8K of RAM into our Super Cart Space
-            memcpy(MemCPU+0x6000, MemCART+(MAX_CART_SIZE-(bank*0x2000)), 0x2000);       // Copy in the new bank of 8K RAM into our working space at >6000
-            super_bank = bank;
+            WriteBankSuperCart((cruAddress-1)/2);   // Swap in the new bank - logic borrowed from MAME
         }
         cart_cru_shadow[cruAddress] = dataBit;
     }
 }
 
+// ------------------------------------------------------------------------------------------
+// The Super Cart RAM lives in the back-end 32K of the cart buffer and is mapped at >6000
+// using the same cartBankPtr as banked cart ROM... so switching banks is just a pointer swap.
+// ------------------------------------------------------------------------------------------
+void WriteBankSuperCart(u8 bank)
+{
+    super_bank = bank & 3;
+    tms9900.bankOffset = SUPERCART_BANK_OFFSET(super_bank);
+    tms9900.cartBankPtr = MemCART+tms9900.bankOffset;
+    TMS9900_MapCart();
+}
+
 u8 cart_cru_read(u16 cruAddress)
 {
     return cart_cru_shadow[cruAddress & 0xF];   // Return shadow value of CRU bit
@@ -780,6 +1032,8 @@ u8 cart_cru_read(u16 cruAddress)
 // ------------------------------------------------------------------------------------------------------------------------
 inline __attribute__((always_inline)) u16 ReadWP_RAM16(u16 address)
 {
+    u8 *page = MemPageRead[address>>8];                   // The page table takes care of scratchpad mirrors and banked RAM (SAMS, Super Cart)
+    if (page) return __builtin_bswap16(*(u16*) (page + (address&0xFF)));
     return __builtin_bswap16(*(u16*) (&MemCPU[address])); // Don't need the 0xFFFE mask here as this is always WP aligned 16-bit access
 }
 
@@ -789,15 +1043,8 @@ inline __attribute__((always_inline)) u16 ReadWP_RAM16(u16 address)
 // --------------------------------------------------------------------------------------------------------------------
 inline __attribute__((always_inline)) u16 ReadWP_RAM16a(u16 address)
 {
-    if (MemType[address>>4])
-    {
-        AddCycleCount(4);
-        if (MemType[address>>4] == MF_SAMS8)
-        {
-            return __builtin_bswap16(*((u16*)(theSAMS.memoryPtr[address>>12] + (address&0x0FFE))));
-        }
-    }
-    return __builtin_bswap16(*(u16*) (&MemCPU[address])); // Don't need the 0xFFFE mask here as this is always WP aligned 16-bit access
+    if (MemType[address>>4]) AddCycleCount(4);
+    return ReadWP_RAM16(address);
 }
 
 // ----------------------------------------------------------------------------------------
@@ -805,18 +1052,14 @@ inline __attribute__((always_inline)) u16 ReadWP_RAM16a(u16 address)
 // ----------------------------------------------------------------------------------------
 ITCM_CODE void WriteWP_RAM16(u16 address, u16 data)
 {
-    if (!MemType[address>>4] && myConfig.RAMMirrors) // If RAM mirrors enabled, handle them by writing to all 4 locations - makes the readback faster
-    {
-        address &= 0x00FE;
-        *((u16*)(MemCPU+(0x8000 | address))) = (data << 8) | (data >> 8);
-        *((u16*)(MemCPU+(0x8100 | address))) = (data << 8) | (data >> 8);
-        *((u16*)(MemCPU+(0x8200 | address))) = (data << 8) | (data >> 8);
-        *((u16*)(MemCPU+(0x8300 | address))) = (data << 8) | (data >> 8);
-    }
-    else
+    u8 *page = MemPageWrite[address>>8];                        // The page table takes care of scratchpad mirrors and banked RAM (SAMS, Super Cart)
+    if (page) *((u16*)(page + (address&0xFF))) = (data << 8) | (data >> 8);
+    else if (MemType[address>>4] == MF_SAMS8)                   // Registers in a SAMS bank that hasn't been written yet
     {
-        *((u16*)(MemCPU+address)) = (data << 8) | (data >> 8);  // Don't need the 0xFFFE mask here as this is always WP aligned 16-bit access
+        u8 *ptr = SAMS_WritePtr(address);
+        if (ptr) *((u16*)ptr) = (data << 8) | (data >> 8);
     }
+    else *((u16*)(MemCPU+address)) = (data << 8) | (data >> 8); // Don't need the 0xFFFE mask here as this is always WP aligned 16-bit access
 }
 
 // --------------------------------------------------------------------------------------------------------------------
@@ -825,29 +1068,8 @@ ITCM_CODE void WriteWP_RAM16(u16 address, u16 data)
 // --------------------------------------------------------------------------------------------------------------------
 ITCM_CODE void WriteWP_RAM16a(u16 address, u16 data)
 {
-    u8 memType = MemType[address>>4];
-
-    if (memType) AddCycleCount(4);  // Anything not intrinsic 16-bit memory incurs the penalty
-
-    if (memType == MF_SAMS8)
-    {
-        *((u16*)(theSAMS.memoryPtr[address>>12] + (address&0xFFE))) = (data << 8) | (data >> 8);
-    }
-    else
-    {
-        if (!memType && myConfig.RAMMirrors) // If RAM mirrors enabled, handle them by writing to all 4 locations - makes the readback faster
-        {
-            address &= 0x00FE;
-            *((u16*)(MemCPU+(0x8000 | address))) = (data << 8) | (data >> 8);
-            *((u16*)(MemCPU+(0x8100 | address))) = (data << 8) | (data >> 8);
-            *((u16*)(MemCPU+(0x8200 | address))) = (data << 8) | (data >> 8);
-            *((u16*)(MemCPU+(0x8300 | address))) = (data << 8) | (data >> 8);
-        }
-        else
-        {
-            *((u16*)(MemCPU+address)) = (data << 8) | (data >> 8);  // Don't need the 0xFFFE mask here as this is always WP aligned 16-bit access
-        }
-    }
+    if (MemType[address>>4]) AddCycleCount(4);  // Anything not intrinsic 16-bit memory incurs the penalty
+    WriteWP_RAM16(address, data);
 }
 
 // -----------------------------------------------------------------------------------------------
@@ -858,50 +1080,104 @@ ITCM_CODE void WriteWP_RAM16a(u16 address, u16 data)
 inline __attribute__((always_inline)) u16 ReadPC16(void)
 {
     u16 address = tms9900.PC; tms9900.PC+=2;
+    MEM_STAT(MEM_STAT_FETCH, address);
 
     // This will trap out anything that isn't below 0x2000 which is console ROM and heavily utilized...
     if (address & 0xE000)
     {
-        u8 memType = MemType[address>>4];
-        if (memType)
+        u8 *page = MemPageRead[address>>8];
+        if (page)   // Cart ROM (in the current bank), expanded RAM, SAMS, scratchpad... all straight from the page table
         {
-            AddCycleCount(4); // Penalty for anything not internal ROM or Workspace RAM
-            if (memType == MF_CART)
-            {
-                return __builtin_bswap16(*(u16*) (&tms9900.cartBankPtr[address&0x1ffe]));
-            }
+            AddCycleCount(PAGE_PENALTY(address));
+            return __builtin_bswap16(*((u16*)(page + (address&0xFE))));
         }
+        if (MemType[address>>4]) AddCycleCount(4); // Penalty for anything not internal ROM or Workspace RAM
     }
     return __builtin_bswap16(*((u16*)(&MemCPU[address&0xFFFE])));
 }
 
 // -------------------------------------------------------------------------------------------------------------------------------------
-// This is the accurate version of the above which handles SAMS (yes, code can run from SAMS!) - this chews up more emulation CPU time.
+// This is the accurate version of the above which handles SAMS (yes, code can run from SAMS!). Since the page table always points
+// at the currently mapped SAMS banks, this is now exactly the same fetch - we keep it so the SAMS core has its own fetch handler.
 // -------------------------------------------------------------------------------------------------------------------------------------
 ITCM_CODE u16 ReadPC16a(void)
 {
-    u16 address = tms9900.PC; tms9900.PC+=2;
+    return ReadPC16();
+}
 
-    // This will trap out anything that isn't below 0x2000 which is console ROM and heavily utilized...
-    if (address & 0xE000)
+// ---------------------------------------------------------------------------------------------------------------------
+// The decoded instruction cache. Console ROM at >0000 and banked cart ROM at >6000 never change underneath us, so
+// once we've fetched and decoded an opcode there we can remember it. Each of the 8192 entries is two 32-bit words:
+//   [0] the key - this is the PC for console ROM or the PC plus the bankOffset for cart ROM (so banks never alias)
+//   [1] the opcode in the low 16 bits, the pre-decoded OpcodeDecode[] value in bits 16-23 and the fetch cycles above
+// Because the cart bank is part of the key, bank switching needs no invalidation (and it doesn't matter where in
+// memory a bank lives - streamed carts move banks around as they are paged in) and since we never cache anything
+// that is RAM backed (expanded RAM, SAMS, Super Cart, MBX, DSR space) we never have to snoop memory writes either.
+// The cache is flushed on reset and savestate restore. All writes are 32-bit as the VRAM doesn't do 8-bit writes.
+// ---------------------------------------------------------------------------------------------------------------------
+#define DECODE_CACHE_ENTRIES    8192
+#define DECODE_CACHE_REGIONS    0x09        // Bit mask of the 8K regions that are cacheable: >0000 (console ROM) and >6000 (cart ROM)
+#define DECODE_CACHE_EMPTY      0x00000001  // Keys are always even so this never matches
+
+void TMS9900_FlushDecodeCache(void)
+{
+    for (u32 i=0; i<DECODE_CACHE_ENTRIES; i++)
     {
-        u8 memType = MemType[address>>4];
-        if (memType)
-        {
-            AddCycleCount(4); // Penalty for anything not internal ROM or Workspace RAM
-            if (memType == MF_CART)
-            {
-                return __builtin_bswap16(*(u16*) (&tms9900.cartBankPtr[address&0x1ffe]));
-            }
-            else if (memType == MF_SAMS8)
-            {
-                return __builtin_bswap16(*((u16*)(theSAMS.memoryPtr[address>>12] + (address&0x0ffe))));
-            }
-        }
+        DecodeCache[(i<<1)+0] = DECODE_CACHE_EMPTY;
+        DecodeCache[(i<<1)+1] = 0x00000000;
     }
-    return __builtin_bswap16(*((u16*)(&MemCPU[address&0xFFFE])));
 }
 
+// -------------------------------------------------------------------------------------------------
+// On a miss we fetch the opcode the normal way and, if it came from ROM, remember it for next time.
+// The fast ReadPC16() is fine here as we only get called for addresses in the two ROM regions.
+// -------------------------------------------------------------------------------------------------
+ITCM_CODE u8 DecodeCacheMiss(u32 *entry, u32 key)
+{
+    u16 address = tms9900.PC;
+    u32 cycles  = tms9900.cycles;
+
+    tms9900.currentOp = ReadPC16();
+    u8 op8 = DecodeOpcode(tms9900.currentOp);
+
+    if ((address < 0x2000) || (MemType[address>>4] == MF_CART))
+    {
+        entry[0] = key;
+        entry[1] = tms9900.currentOp | (op8 << 16) | ((tms9900.cycles - cycles) << 24);
+    }
+
+    return op8;
+}
+
+// -------------------------------------------------------------------------------------------------
+// Fetch the next opcode at the PC and return the pre-decoded op8 for dispatch. This is used at the
+// top of every instruction and so is as small as we can make it - a cache hit is just a key compare.
+// -------------------------------------------------------------------------------------------------
+static inline __attribute__((always_inline)) u8 FetchOpcodeCached(void)
+{
+    u32 key = tms9900.PC + (((tms9900.PC & 0xE000) == 0x6000) ? tms9900.bankOffset : 0);
+    u32 *entry = &DecodeCache[tms9900.PC & ((DECODE_CACHE_ENTRIES-1)<<1)];    // Two words per entry so the even PC is already the right index
+
+    if (entry[0] == key)
+    {
+        u32 info = entry[1];
+        MEM_STAT(MEM_STAT_FETCH, tms9900.PC);
+        tms9900.PC += 2;
+        AddCycleCount(info >> 24);
+        tms9900.currentOp = (u16)info;
+        return (u8)(info >> 16);
+    }
+
+    return DecodeCacheMiss(entry, key);
+}
+
+// -------------------------------------------------------------------------------------------------------
+// Instruction fetch for the CPU run loops - ROM goes through the decoded cache and everything else (RAM)
+// uses the PC reader that is passed in (the normal ReadPC16() or the SAMS aware ReadPC16a() version).
+// -------------------------------------------------------------------------------------------------------
+#define FETCH_OPCODE(op8, ReadPC)                                                           \
+    if ((DECODE_CACHE_REGIONS >> (tms9900.PC >> 13)) & 1) op8 = FetchOpcodeCached();        \
+    else {tms9900.currentOp = ReadPC(); op8 = DecodeOpcode(tms9900.currentOp);}
 
 
 // ------------------------------------------------------------------------------------
@@ -941,6 +1217,15 @@ ITCM_CODE u16 MemoryRead16(u16 address)
 {
     u16 retVal;
     address &= 0xFFFE;
+    MEM_STAT(MEM_STAT_READ, address);
+
+    u8 *page = MemPageRead[address>>8];
+    if (page)   // Plain memory - straight from the page table
+    {
+        AddCycleCount(PAGE_PENALTY(address));
+        return __builtin_bswap16(*(u16*) (page + (address&0xFF)));
+    }
+
     u8 memType = MemType[address>>4];
 
     if (memType)
@@ -981,8 +1266,8 @@ ITCM_CODE u16 MemoryRead16(u16 address)
         }
     }
 
-    // This is either console ROM or workspace RAM
-    return __builtin_bswap16(*(u16*) (&MemCPU[address]));
+    // This is either console ROM or workspace RAM (folded onto the one scratchpad copy at >8300)
+    return __builtin_bswap16(*(u16*) (&MemCPU[SCRATCHPAD_FOLD(address)]));
 }
 
 // --------------------------------------------------------------------------------------------------
@@ -992,6 +1277,14 @@ ITCM_CODE u16 MemoryRead16(u16 address)
 // --------------------------------------------------------------------------------------------------
 ITCM_CODE u8 MemoryRead8(u16 address)
 {
+    MEM_STAT(MEM_STAT_READ, address);
+    u8 *page = MemPageRead[address>>8];
+    if (page)   // Plain memory - straight from the page table
+    {
+        AddCycleCount(PAGE_PENALTY(address));
+        return page[address&0xFF];
+    }
+
     u8 memType = MemType[address>>4];
 
     if (memType)
@@ -1030,7 +1323,7 @@ ITCM_CODE u8 MemoryRead8(u16 address)
         }
     }
 
-    return MemCPU[address]; // This is either console ROM or workspace RAM
+    return MemCPU[SCRATCHPAD_FOLD(address)]; // This is either console ROM or workspace RAM (folded onto the one scratchpad copy at >8300)
 }
 
 
@@ -1046,6 +1339,15 @@ ITCM_CODE u8 MemoryRead8(u16 address)
 ITCM_CODE void MemoryWrite16(u16 address, u16 data)
 {
     address &= 0xFFFE;
+    MEM_STAT(MEM_STAT_WRITE, address);
+
+    u8 *page = MemPageWrite[address>>8];
+    if (page)   // Expanded RAM or SAMS - straight to the page table
+    {
+        AddCycleCount(PAGE_PENALTY(address));
+        *((u16*)(page + (address&0xFF))) = (data << 8) | (data >> 8);
+        return;
+    }
 
     u8 memType = MemType[address>>4];
 
@@ -1082,8 +1384,11 @@ ITCM_CODE void MemoryWrite16(u16 address, u16 data)
                     *((u16*)(MemCPU+address)) = (data << 8) | (data >> 8);
                 }
                 break;
-            case MF_SAMS8:
-                *((u16*)(theSAMS.memoryPtr[address>>12] + (address & 0xFFF))) = (data << 8) | (data >> 8);
+            case MF_SAMS8:  // Only the first write to a SAMS bank lands here - after that the page table has it
+                {
+                    u8 *ptr = SAMS_WritePtr(address);
+                    if (ptr) *((u16*)ptr) = (data << 8) | (data >> 8);
+                }
                 break;
             case MF_RAM8:
                 *((u16*)(MemCPU+address)) = (data << 8) | (data >> 8);
@@ -1092,27 +1397,26 @@ ITCM_CODE void MemoryWrite16(u16 address, u16 data)
                 break;
         }
     }
-    else    // This has to be workspace RAM which deals with mirrors...
+    else    // This has to be workspace RAM (the page table normally handles this) which deals with mirrors...
     {
         if (address & 0x8000)   // Make sure this is RAM and not an inadvertant write to Console ROM (also 16-bit)
         {
-            if (myConfig.RAMMirrors)    // We write to all mirrors so that read-back is quick and easy
-            {
-                *((u16*)(MemCPU+(0x8000 | (address&0xff)))) = (data << 8) | (data >> 8);
-                *((u16*)(MemCPU+(0x8100 | (address&0xff)))) = (data << 8) | (data >> 8);
-                *((u16*)(MemCPU+(0x8200 | (address&0xff)))) = (data << 8) | (data >> 8);
-                *((u16*)(MemCPU+(0x8300 | (address&0xff)))) = (data << 8) | (data >> 8);
-            }
-            else
-            {
-                *((u16*)(MemCPU+address)) = (data << 8) | (data >> 8);
-            }
+            *((u16*)(MemCPU+(0x8300 | (address&0xff)))) = (data << 8) | (data >> 8);   // Any mirror lands on the one copy at >8300
         }
     }
 }
 
 ITCM_CODE void MemoryWrite8(u16 address, u8 data)
 {
+    MEM_STAT(MEM_STAT_WRITE, address);
+    u8 *page = MemPageWrite[address>>8];
+    if (page)   // Expanded RAM or SAMS - straight to the page table
+    {
+        AddCycleCount(PAGE_PENALTY(address));
+        page[address&0xFF] = data;
+        return;
+    }
+
     u8 memType = MemType[address>>4];
 
     if (memType)
@@ -1149,8 +1453,11 @@ ITCM_CODE void MemoryWrite8(u16 address, u8 data)
             case MF_DISK:
                 WriteTICCRegister(address, data);  // Disk Controller
                 break;
-            case MF_SAMS8:
-                *(theSAMS.memoryPtr[address>>12] + (address & 0xFFF)) = data;
+            case MF_SAMS8:  // Only the first write to a SAMS bank lands here - after that the page table has it
+                {
+                    u8 *ptr = SAMS_WritePtr(address);
+                    if (ptr) *ptr = data;
+                }
                 break;
             case MF_RAM8:
                 MemCPU[address] = data;    // Expanded 32K RAM
@@ -1159,23 +1466,358 @@ ITCM_CODE void MemoryWrite8(u16 address, u8 data)
                 break;
         }
     }
-    else    // This has to be workspace RAM which deals with mirrors...
+    else    // This has to be workspace RAM (the page table normally handles this) which deals with mirrors...
     {
         if (address & 0x8000)   // Make sure this is RAM and not an inadvertant write to Console ROM
         {
-            if (myConfig.RAMMirrors)    // We write to all mirrors so that read-back is quick and easy
-            {
-                MemCPU[0x8000 | (address&0xff)] = data;
-                MemCPU[0x8100 | (address&0xff)] = data;
-                MemCPU[0x8200 | (address&0xff)] = data;
-                MemCPU[0x8300 | (address&0xff)] = data;
-            }
-            else
-            {
-                MemCPU[address] = data;
-            }
+            MemCPU[0x8300 | (address&0xff)] = data;     // Any mirror lands on the one copy at >8300
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------
+// Superinstruction fusion for the two most common block transfer loops on the TI-99/4a:
+//
+//    MOVB *Rs+,@>8C00     (or *Rd with Rd=>8C00)         MOVB @>9800,*Rd+     (or *Rs with Rs=>9800 - also VDP >8800)
+//    DEC  Rc                                             DEC  Rc
+//    JNE  (back to MOVB)                                 JNE  (back to MOVB)
+//
+// The console ROM, the GPL interpreter and most carts move VDP and GROM data around this way. Instead of fetching,
+// decoding and dispatching three instructions for every byte moved, we recognize the loop when we hit the MOVB and run
+// the iterations here - each one costs exactly the cycles the unfused instructions would have (including the fetch
+// penalty for every code word). We stop at the end of the scanline just as the normal run loop would, with the
+// registers, status and PC left as if we had run the loop normally, so we simply pick up where we left off next time.
+//
+// We are conservative: the workspace must be in scratchpad RAM, the code must be in plain (non-SAMS) memory, the
+// registers must all be different and the data pointer must not wander into the scratchpad or the memory-mapped
+// devices. Anything else is left to the normal instruction-by-instruction emulation. Returns 1 if we ran the loop.
+// ---------------------------------------------------------------------------------------------------------------------------
+#define FUSION_CANDIDATE(op)  ((0x6880 >> ((((op)>>4)&3) | (((op)>>8)&0xC))) & 1)   // Ts/Td modes of *Rs+ to */@ or */@ to *Rd+
+
+static inline u8 CodeFetchPenalty(u16 address)
+{
+    return ((address & 0xE000) && MemType[address>>4]) ? 4:0;  // Same fetch penalty that ReadPC16() would add
+}
+
+static inline u16 PeekCode16(u16 address)
+{
+    u8 *page = MemPageRead[address>>8];
+    if (page) return __builtin_bswap16(*(u16*) (page + (address&0xFE)));
+    return __builtin_bswap16(*((u16*)(&MemCPU[address&0xFFFE])));
+}
+
+u8 TMS9900_FuseTransferLoop(u32 cycleLimit)
+{
+    u16 op = tms9900.currentOp;
+    u16 pc = tms9900.PC - 2;        // Address of the MOVB we are sitting on
+    u16 ws = tms9900.WP;
+
+    // Workspace fully in the scratchpad so register access is penalty-free and never SAMS mapped
+    if (((ws & 0xFC00) != 0x8000) || ((ws & 0x3FF) > 0x3E0)) return 0;
+
+    // The loop code must be in plain memory - we don't fuse anything running from SAMS or the DSR space
+    u8 codeType = MemType[pc>>4];
+    if ((codeType != MF_RAM8) && (codeType != MF_CART) && (codeType != MF_CART_NB) && ((codeType != MF_MEM16) || (pc >= 0x2000))) return 0;
+
+    u16 ts = (op>>4)  & 3;
+    u16 td = (op>>10) & 3;
+    u8  toVDP = (ts == 3);          // *Rs+ into the VDP, otherwise the GROM/VDP read port into *Rd+
+    u16 rPtr  = toVDP ? (op & 0xF) : ((op>>6) & 0xF);
+    u16 rPort = 0xFF;               // Register holding the port address (if not symbolic)
+    u16 len   = 2;                  // Length of the MOVB in bytes
+    u16 port;
+
+    if ((toVDP ? td : ts) == 2)     // @>xxxx symbolic - no indexing allowed
+    {
+        if (toVDP ? ((op>>6) & 0xF) : (op & 0xF)) return 0;
+        port = PeekCode16(pc+2);
+        len = 4;
+    }
+    else                            // *Rx pointing at the port
+    {
+        rPort = toVDP ? ((op>>6) & 0xF) : (op & 0xF);
+        port = ReadWP_RAM16(WP_REG(rPort));
+    }
+
+    u8 portType = MemType[port>>4];
+    if (port & 2) return 0;         // Only the data ports - not the address/status ports
+    if (toVDP  && (portType != MF_VDP_W)) return 0;
+    if (!toVDP && (portType != MF_GROMR) && (portType != MF_VDP_R)) return 0;
+
+    // Now make sure this really is followed by DEC Rc and JNE back to the MOVB
+    u16 decOp = PeekCode16(pc+len);
+    if ((decOp & 0xFFF0) != 0x0600) return 0;
+    u16 rCount = decOp & 0xF;
+    u16 jneOp  = PeekCode16(pc+len+2);
+    if (jneOp != (0x1600 | (u8)(-((len+4)>>1)))) return 0;
+    if ((rCount == rPtr) || (rPort == rPtr) || (rPort == rCount)) return 0;
+    if (MemType[(u16)(pc+len+2)>>4] != codeType) return 0;
+
+    // Per-iteration cycle costs - exactly what the individual instructions would add up to
+    u32 fetchMovb = CodeFetchPenalty(pc);
+    u32 movbCost  = 14 + 6 + 4 + ((len == 4) ? (8 + CodeFetchPenalty(pc+2)) : 4);   // base + *Rx+ + port penalty + port addressing
+    if (toVDP) movbCost += 4;                                                          // Phantom read of the VDP port
+    u32 decCost   = 10 + CodeFetchPenalty(pc+len);
+    u32 jneCost   = CodeFetchPenalty(pc+len+2);
+
+    u16 ptr   = ReadWP_RAM16(WP_REG(rPtr));
+    u16 count = ReadWP_RAM16(WP_REG(rCount));
+    u16 dData = 0;
+    u8  data8 = 0;
+    u8  first = 1;
+
+    do
+    {
+        // Don't let the data pointer wander somewhere that could change the registers, the code or a device...
+        if (toVDP)
+        {
+            if ((ptr & 0xFC00) == 0x8000) break;
+        }
+        else
+        {
+            u8 dstType = MemType[ptr>>4];
+            if ((dstType != MF_RAM8) && (dstType != MF_SAMS8)) break;
+            if ((u16)(ptr - pc) < (len+4)) break;
+        }
+
+        if (!first) AddCycleCount(fetchMovb); // The MOVB opcode fetch for the first pass was already counted
+        first = 0;
+
+        // MOVB
+        AddCycleCount(movbCost);
+        if (toVDP)
+        {
+            data8 = MemoryRead8(ptr);
+            WrData9918(data8);
+        }
+        else
+        {
+            data8 = (portType == MF_GROMR) ? ReadGROM() : RdData9918();
+            PhantomMemoryRead(ptr);
+            MemoryWrite8(ptr, data8);
         }
+        ptr++;
+
+        // DEC Rc
+        AddCycleCount(decCost);
+        dData = count--;
+
+        // JNE
+        AddCycleCount(jneCost + (count ? 10:8));
+    }
+    while (count && ((s32)(tms9900.cycles - cycleLimit) < 0));
+
+    if (first) return 0;    // Didn't get to do anything - let the normal MOVB handle it
+
+    // Leave everything exactly as the unfused loop would have...
+    WriteWP_RAM16(WP_REG(rPtr), ptr);
+    WriteWP_RAM16(WP_REG(rCount), count);
+
+    STATUS_LAEP8(data8, 0);                                                     // From the last MOVB
+    STATUS_LAE16(count, ST_C | ST_OV);                                          // From the last DEC
+    if (count < dData) tms9900.ST |= ST_C;
+    if ((dData & 0x8000) && !(count & 0x8000)) tms9900.ST |= ST_OV;
+
+    tms9900.PC = count ? pc : (pc+len+4);
+    tms9900.currentOp  = jneOp;
+    tms9900.srcAddress = WP_REG(rCount);
+    tms9900.dstAddress = toVDP ? port : (ptr-1);
+
+    return 1;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------
+// Idle loop detection. Lots of carts sit in a tight loop waiting for something to happen - polling the VDP status at >8802
+// for the vertical blank, waiting on a scratchpad flag that the interrupt routine sets, or just a JMP $ with interrupts on.
+// Nothing the CPU does in such a loop can change the outcome until the outside world changes - and the outside world
+// (VDP status, interrupts, keyboard, timer) only changes between scanlines. So when we see a short backward jump whose loop
+// body can only write to the workspace registers (and only reads plain memory or the VDP and console GROM ports, so no read
+// can change a device we don't track), we take a snapshot of everything the loop could possibly see. If the
+// next time around the snapshot is identical, every further pass through the loop will be identical until the end of the
+// scanline, and we can simply add the cycles for as many whole passes as fit rather than emulate them one by one.
+// ---------------------------------------------------------------------------------------------------------------------------
+#define IDLE_LOOP_MAX_WORDS     8       // Only tight loops - backward jumps of at most this many words are considered
+
+u32 idle_skipped_cycles = 0;    // Only used for debug purposes... so it doesn't need to be in fast memory
+
+typedef struct
+{
+    u16 loopTop;                // Address the backward jump goes to
+    u16 loopJump;               // Address of the backward jump itself (0 = nothing being watched)
+    u8  isPure;                 // Loop body only reads memory and writes workspace registers
+    u8  isArmed;                // We have a snapshot from the last time around the loop
+    u16 WP, ST, cpuInt;         // Snapshot of everything the loop body can see...
+    u16 VAddr, gromAddress;
+    u8  VDPStatus, VDPDlatch, VDPCtrlLatch, gromLoHi;
+    u16 regs[16];
+    u32 cycles;                 // CPU cycles when we last came around the loop
+} IdleLoop_t;
+
+IdleLoop_t idleLoop;
+
+extern u16 batchLines;      // Scanline batching (see LoopTMS9900)
+extern u32 batchStart;
+
+// -------------------------------------------------------------------------------------------------------
+// Can reading this operand change anything the snapshot doesn't cover? Workspace registers and symbolic
+// addresses in plain memory or the VDP and console GROM read ports (whose state is snapshotted) are fine.
+// Reads of the disk controller, speech, p-code GROMs, etc. move those devices along - and an indirect or
+// indexed address could land on any of them, so those are never considered idle.
+// -------------------------------------------------------------------------------------------------------
+static u8 IdleLoopReadIsPure(u16 t, u16 reg, u16 pc)
+{
+    if (t == 0) return 1;
+    if ((t != 2) || (reg != 0)) return 0;
+
+    switch (MemType[PeekCode16(pc)>>4])
+    {
+        case MF_MEM16: case MF_RAM8: case MF_SAMS8: case MF_CART: case MF_CART_NB:
+        case MF_VDP_R: case MF_GROMR:
+            return 1;
     }
+    return 0;
+}
+
+// -------------------------------------------------------------------------------------------------------
+// Walk the loop body and make sure every instruction only reads memory that has no side effects and
+// writes workspace registers. Any jumps inside the loop must stay inside the loop (or fall out of the
+// bottom of it).
+// -------------------------------------------------------------------------------------------------------
+static u8 IdleLoopIsPure(u16 top, u16 jump)
+{
+    u16 pc = top;
+
+    while (pc < jump)
+    {
+        u16 op = PeekCode16(pc); pc += 2;
+        u16 ts = (op>>4)  & 3;
+        u16 td = (op>>10) & 3;
+
+        switch (DecodeOpcode(op))
+        {
+            case op_c: case op_cb:                                      // Compares don't write anything - but read both operands
+                if (!IdleLoopReadIsPure(ts, op & 0xF, pc)) return 0;
+                if (ts == 2) pc += 2;
+                if (!IdleLoopReadIsPure(td, (op>>6) & 0xF, pc)) return 0;
+                if (td == 2) pc += 2;
+                break;
+
+            case op_szc: case op_szcb: case op_s:   case op_sb:   case op_a:   case op_ab:
+            case op_mov: case op_movb: case op_soc: case op_socb:       // Two operand - destination must be a register
+                if (td != 0) return 0;
+                if (!IdleLoopReadIsPure(ts, op & 0xF, pc)) return 0;
+                if (ts == 2) pc += 2;
+                break;
+
+            case op_coc: case op_czc: case op_xor: case op_mpy: case op_div:   // Destination is always a register
+                if (!IdleLoopReadIsPure(ts, op & 0xF, pc)) return 0;
+                if (ts == 2) pc += 2;
+                break;
+
+            case op_clr: case op_neg: case op_inv: case op_inc:  case op_inct:
+            case op_dec: case op_dect: case op_seto: case op_abs: case op_swpb:  // Single operand - must be a register
+                if (ts != 0) return 0;
+                break;
+
+            case op_sra: case op_srl: case op_sla: case op_src:
+            case op_stwp: case op_stst:
+                break;
+
+            case op_li: case op_ai: case op_andi: case op_ori: case op_ci: case op_limi:
+                pc += 2;
+                break;
+
+            case op_jmp: case op_jlt: case op_jle: case op_jeq: case op_jhe: case op_jgt: case op_jne:
+            case op_jnc: case op_joc: case op_jno: case op_jl:  case op_jh:  case op_jop:
+                {
+                    u16 target = pc + (((s8)op)<<1);
+                    if ((target < top) || (target > (jump+2))) return 0;
+                }
+                break;
+
+            default:                                                    // Anything else (BLWP, X, CRU reads and writes, etc) is not idle
+                return 0;
+        }
+    }
+
+    return (pc == jump);
+}
+
+static inline void IdleLoopSnapshot(void)
+{
+    memcpy(idleLoop.regs, &MemCPU[SCRATCHPAD_FOLD(tms9900.WP)], sizeof(idleLoop.regs));
+    idleLoop.WP             = tms9900.WP;
+    idleLoop.ST             = tms9900.ST;
+    idleLoop.cpuInt         = tms9900.cpuInt;
+    idleLoop.VAddr          = VAddr;
+    idleLoop.gromAddress    = tms9900.gromAddress;
+    idleLoop.VDPStatus      = VDPStatus;
+    idleLoop.VDPDlatch      = VDPDlatch;
+    idleLoop.VDPCtrlLatch   = VDPCtrlLatch;
+    idleLoop.gromLoHi       = (tms9900.gromReadLoHi << 1) | tms9900.gromWriteLoHi;
+    idleLoop.cycles         = tms9900.cycles;
+}
+
+static inline u8 IdleLoopSnapshotMatches(void)
+{
+    return ((idleLoop.WP             == tms9900.WP)           &&
+            (idleLoop.ST             == tms9900.ST)           &&
+            (idleLoop.cpuInt         == tms9900.cpuInt)       &&
+            (idleLoop.VAddr          == VAddr)                &&
+            (idleLoop.gromAddress    == tms9900.gromAddress)  &&
+            (idleLoop.VDPStatus      == VDPStatus)            &&
+            (idleLoop.VDPDlatch      == VDPDlatch)            &&
+            (idleLoop.VDPCtrlLatch   == VDPCtrlLatch)         &&
+            (idleLoop.gromLoHi       == ((tms9900.gromReadLoHi << 1) | tms9900.gromWriteLoHi)) &&
+            (memcmp(idleLoop.regs, &MemCPU[SCRATCHPAD_FOLD(tms9900.WP)], sizeof(idleLoop.regs)) == 0));
+}
+
+// -------------------------------------------------------------------------------------------------------
+// Called on every short backward jump that is taken. The PC has already been moved to the loop top.
+// -------------------------------------------------------------------------------------------------------
+void TMS9900_IdleLoopCheck(u32 cycleLimit)
+{
+    u16 top  = tms9900.PC;
+    u16 jump = top - (((s8)tms9900.currentOp)<<1) - 2;
+
+    if ((jump != idleLoop.loopJump) || (top != idleLoop.loopTop))
+    {
+        // A new loop - see if it's something we can fast-forward. Only plain code with the workspace in the scratchpad.
+        u8 codeType = MemType[jump>>4];
+        idleLoop.loopJump = jump;
+        idleLoop.loopTop  = top;
+        idleLoop.isArmed  = 0;
+        idleLoop.isPure   = (((tms9900.WP & 0xFC00) == 0x8000) && ((tms9900.WP & 0xFF) <= 0xE0) && (MemType[top>>4] == codeType) &&
+                             ((codeType == MF_RAM8) || (codeType == MF_CART) || (codeType == MF_CART_NB) || ((codeType == MF_MEM16) && (jump < 0x2000))) &&
+                             IdleLoopIsPure(top, jump));
+    }
+
+    if (!idleLoop.isPure) return;
+
+    STATUS_SYNC();  // So the snapshot compares the real L> A> EQ bits
+
+    if (idleLoop.isArmed && IdleLoopSnapshotMatches())
+    {
+        // When running a block of scanlines, the VDP still changes between the lines of the block (collisions, 5th sprite)
+        // and is only rendered when the block completes - so never skip past the end of the line the CPU is on.
+        if (batchLines > 1)
+        {
+            u32 lineEnd = batchStart + (((tms9900.cycles - batchStart) / SCANLINE_CYCLES) + 1) * SCANLINE_CYCLES;
+            if ((s32)(lineEnd - cycleLimit) < 0) cycleLimit = lineEnd;
+        }
+
+        // Same state as last time around - skip as many whole passes as fit in the rest of this scanline
+        u32 passCycles = tms9900.cycles - idleLoop.cycles;
+        if (passCycles && ((s32)(tms9900.cycles - cycleLimit) < 0))
+        {
+            u32 skip = ((cycleLimit - tms9900.cycles) / passCycles) * passCycles;
+            tms9900.cycles += skip;
+            idle_skipped_cycles += skip;
+        }
+    }
+
+    IdleLoopSnapshot();
+    idleLoop.isArmed = 1;
 }
 
 
@@ -1367,6 +2009,7 @@ void TMS9900_ContextSwitch(u16 address)
     tms9900.WP &= 0xFFFE;                       // Ensure WP is word-aligned
     MemoryWrite16(WP_REG(13), old_wp);          // Set the old Workspace Pointer
     MemoryWrite16(WP_REG(14), tms9900.PC);      // Set the old PC
+    STATUS_SYNC();                              // The saved Status must have current L> A> EQ bits
     MemoryWrite16(WP_REG(15), tms9900.ST);      // Set the old Status
     tms9900.PC = MemoryRead16(address+2);       // Set the new PC based on original workspace
     tms9900.PC &= 0xFFFE;                       // Ensure PC is word-aligned
@@ -1395,6 +2038,15 @@ void TMS9900_HandlePendingInterrupts(void)
 }
 
 
+// -------------------------------------------------------------------------------------
+// By default the opcode handlers in tms9900.inc are just the cases of a switch() and
+// the transfer loop fusion and idle loop detection are off (these need the run loops)
+// -------------------------------------------------------------------------------------
+#define OPCODE(op)              case op:
+#define NEXT_OP                 break
+#define FUSE_TRANSFER_LOOP()    0
+#define IDLE_LOOP_CHECK()
+
 // -------------------------------------------------------------
 // Mainly for the X = Execute instruction (not frequently used)
 // This chews up almost 20K of program space which isn't ideal
@@ -1405,116 +2057,167 @@ void ExecuteOneInstruction(u16 opcode)
 {
     u8 data8;
     u16 data16;
-    u8 op8 = (u8)OpcodeLookup[opcode];
+    u8 op8 = DecodeOpcode(opcode);
     switch (op8)
     {
     #include "tms9900.inc"
     }
 }
 
-// --------------------------------------------------------------------------------------------------------------------------------
-// A bit more CPU intensive - this runs somewhere between 10 and 15% slower on the DS but allows us to handle more
-// complex emulation such as TMS9901 Timer, SAMS memory and/or the IDLE instruction. This only gets enabled when needed...
-// most carts will use TMS9900_Run() instead for much improved emulation speed (mostly needed for the older DS-Lite/Phat hardware)
-// --------------------------------------------------------------------------------------------------------------------------------
-void TMS9900_RunAccurate(void)
-{
-    u32 myCounter = tms9900.cycles+191-tms9900.cycleDelta;
-
-    // ---------------------------------------------------------------------------------------------------
-    // Timer support is quite preliminary - but it's only used by cassette tape load/timeout and a tiny
-    // number of other programs use it. We don't get it quite right here... we are only decrementing the
-    // timer by 3 ticks every scanline which approximates the 9901 timer (64 CPU clocks per tick).
-    // Classic 99 does this more accurately and checks after every instruction for a possible decrement.
-    // But this is good enough for DS use and produces a roughly 46.9KHz timer which isn't too far off.
-    // ---------------------------------------------------------------------------------------------------
-    if (tms9901.TimerCounter)   // Has a timer been programmed?
-    {
-        if (tms9901.PinState[PIN_TIMER_OR_IO] == IO_MODE)   // Timer only runs when we are in IO Mode
-        {
-            // This is a gross misrepresentation of how the timer works... needs to be more accurate but good enough for now
-            if (tms9901.TimerCounter > 3) tms9901.TimerCounter -= 3;
-            else
-            {
-                // Timeout... possibly raise interrupt and reload timer
-                TMS9901_RaiseTimerInterrupt();
-                tms9901.TimerCounter = tms9901.TimerStart;
-            }
-        }
-    }
-
-    do
-    {
-        if (tms9900.cpuInt) TMS9900_HandlePendingInterrupts();
-        if (tms9900.idleReq)
-        {
-            tms9900.cycles += 4;
-            idle_counter++;
-        }
-        else
-        {
-            u8 data8;
-            u16 data16;
+// --------------------------------------------------------------------------------------
+// The main run loops get transfer loop fusion and idle loop detection. Both need to
+// know where the CPU must stop - which is the next scheduled event (CYCLE_LIMIT). We
+// read it live rather than keeping a copy as the CPU itself can schedule an earlier
+// event (e.g. starting the 9901 timer) and we want to stop right on time for it.
+// --------------------------------------------------------------------------------------
+#define CYCLE_LIMIT             sched.next
+#define CYCLES_REMAIN()         ((s32)(tms9900.cycles - CYCLE_LIMIT) < 0)
 
-            if (tms9900.PC == 0x40e8) HandleTICCSector();  // Disk access is not common but trap it here...
-            tms9900.currentOp = ReadPC16a();
-            u8 op8 = (u8)OpcodeLookup[tms9900.currentOp];
+#undef  FUSE_TRANSFER_LOOP
+#undef  IDLE_LOOP_CHECK
+#define FUSE_TRANSFER_LOOP()    (FUSION_CANDIDATE(tms9900.currentOp) && TMS9900_FuseTransferLoop(CYCLE_LIMIT))
+#define IDLE_LOOP_CHECK()       if ((u8)tms9900.currentOp >= (u8)(-IDLE_LOOP_MAX_WORDS)) TMS9900_IdleLoopCheck(CYCLE_LIMIT)
 
-            switch (op8)
-            {
-// We need to swap in the 'a' = accurate versions of the memory fetch handlers
-// These handlers are a bit slower but necessary to allow for SAMS banked memory access.
-#define ReadWP_RAM16    ReadWP_RAM16a
-#define WriteWP_RAM16   WriteWP_RAM16a
-#define ReadPC16        ReadPC16a
-#define Ts              Ts_Accurate
-#define Td              Td_Accurate
-#define TsTd            TsTd_Accurate
-            #include "tms9900.inc"
-#undef ReadWP_RAM16
-#undef WriteWP_RAM16
-#undef ReadPC16
-#undef Ts
-#undef Td
-#undef TsTd
-            }
-        }
+// --------------------------------------------------------------------------------------------------------------
+// Threaded dispatch. The opcode handlers in tms9900.inc are bracketed by OPCODE() and NEXT_OP. For the normal
+// switch() dispatch these are simply 'case' and 'break'. For threaded dispatch each handler also gets a label
+// and the pre-decoded opcode from OpcodeDecode[] indexes a table of those label addresses. At the end of every
+// handler we fetch the next opcode and jump straight into its handler - no bounds check and no single shared
+// indirect branch that the poor ARM946 can never predict. Anything out of the ordinary (end of scanline, a
+// pending interrupt, the disk DSR trap, IDLE) does a 'break' back out to the main loop which handles it.
+// --------------------------------------------------------------------------------------------------------------
+#ifdef TMS9900_THREADED_DISPATCH
+#undef  OPCODE
+#undef  NEXT_OP
+#define OPCODE(op)  case op: L_##op:
+
+#define THREAD_NEXT(slowPath)                                                   \
+    if (CYCLES_REMAIN() && !(slowPath))                                         \
+    {                                                                           \
+        FETCH_OPCODE(op8, ReadPC16);                                            \
+        goto *OpcodeThread[op8];                                                \
+    }                                                                           \
+    break
+
+#define OPCODE_THREAD_TABLE                                                                                         \
+    static const void *OpcodeThread[op_max] __attribute__((section(".dtcm"))) =                                    \
+    {                                                                                                               \
+        &&L_op_bad,  &&L_op_sra,  &&L_op_srl,  &&L_op_sla,  &&L_op_src,  &&L_op_li,   &&L_op_ai,   &&L_op_andi,    \
+        &&L_op_ori,  &&L_op_ci,   &&L_op_stwp, &&L_op_stst, &&L_op_lwpi, &&L_op_limi, &&L_op_idle, &&L_op_rset,    \
+        &&L_op_rtwp, &&L_op_ckon, &&L_op_ckof, &&L_op_lrex, &&L_op_blwp, &&L_op_b,    &&L_op_x,    &&L_op_clr,     \
+        &&L_op_neg,  &&L_op_inv,  &&L_op_inc,  &&L_op_inct, &&L_op_dec,  &&L_op_dect, &&L_op_bl,   &&L_op_swpb,    \
+        &&L_op_seto, &&L_op_abs,  &&L_op_jmp,  &&L_op_jlt,  &&L_op_jle,  &&L_op_jeq,  &&L_op_jhe,  &&L_op_jgt,     \
+        &&L_op_jne,  &&L_op_jnc,  &&L_op_joc,  &&L_op_jno,  &&L_op_jl,   &&L_op_jh,   &&L_op_jop,  &&L_op_sbo,     \
+        &&L_op_sbz,  &&L_op_tb,   &&L_op_coc,  &&L_op_czc,  &&L_op_xor,  &&L_op_xop,  &&L_op_ldcr, &&L_op_stcr,    \
+        &&L_op_mpy,  &&L_op_div,  &&L_op_szc,  &&L_op_szcb, &&L_op_s,    &&L_op_sb,   &&L_op_c,    &&L_op_cb,      \
+        &&L_op_a,    &&L_op_ab,   &&L_op_mov,  &&L_op_movb, &&L_op_soc,  &&L_op_socb                                \
     }
-    while(tms9900.cycles < myCounter);    // There are 191 CPU clocks per line on the TI
-
-    tms9900.cycleDelta = tms9900.cycles-myCounter;
-}
+#endif
 
 // --------------------------------------------------------------------------------------------------------------
-// Execute 1 scanline worth of TMS9900 instructions. We keep track of the cycle delta - that is, the overage
-// from one scanline to the next and we compensate the next scanline by the appopriate delta to keep things
-// running at the right speed. In practice this has been good enough to render all the TI games properly.
+// Execute TMS9900 instructions up to the next scheduled event (normally the end of the scanline). The events
+// are kept in absolute CPU cycles so the small overage from one run to the next is compensated for when the
+// next run ends at the right time. In practice this has been good enough to render all the TI games properly.
 //
 // This is chewing up a big chunk of the ITCM memory. Right now the entire opcode handling is roughly 20K of
 // fast instruction memory... but it buys us at least 10% speed by keeping those instructions in the cache.
 // --------------------------------------------------------------------------------------------------------------
-ITCM_CODE void TMS9900_Run(void)
+#define CORE_NAME   TMS9900_Run
+#define CORE_ATTR   ITCM_CODE
+#define CORE_SAMS   0
+#define CORE_IDLE   0
+#include "tms9900core.inc"
+
+// --------------------------------------------------------------------------------------------------------------------------------
+// The more CPU intensive variants - the SAMS aware memory handlers run somewhere between 10 and 15% slower on the DS and the
+// IDLE check costs a little on every instruction. Each variant only pays for what the running program actually needs... most
+// carts will use TMS9900_Run() above for much improved emulation speed (mostly needed for the older DS-Lite/Phat hardware)
+// --------------------------------------------------------------------------------------------------------------------------------
+#define CORE_NAME   TMS9900_RunIdle
+#define CORE_ATTR
+#define CORE_SAMS   0
+#define CORE_IDLE   1
+#include "tms9900core.inc"
+
+#define CORE_NAME   TMS9900_RunSAMS
+#define CORE_ATTR
+#define CORE_SAMS   1
+#define CORE_IDLE   0
+#include "tms9900core.inc"
+
+#define CORE_NAME   TMS9900_RunAccurate
+#define CORE_ATTR
+#define CORE_SAMS   1
+#define CORE_IDLE   1
+#include "tms9900core.inc"
+
+// -----------------------------------------------------------------------------------------------------
+// The CPU core to use for each combination of the ACCURATE_EMU_xxx flags. The timer is handled by the
+// event scheduler so it doesn't need a core of its own - it shares with the non-timer core.
+// -----------------------------------------------------------------------------------------------------
+static void (* const TMS9900_Cores[8])(void) =
 {
-    u32 myCounter = tms9900.cycles+191-tms9900.cycleDelta;
+    TMS9900_Run,            // No special handling
+    TMS9900_RunIdle,        // IDLE
+    TMS9900_Run,            // TIMER
+    TMS9900_RunIdle,        // TIMER + IDLE
+    TMS9900_RunSAMS,        // SAMS
+    TMS9900_RunAccurate,    // SAMS + IDLE
+    TMS9900_RunSAMS,        // SAMS + TIMER
+    TMS9900_RunAccurate,    // SAMS + TIMER + IDLE
+};
 
-    do
-    {
-        u8 data8;
-        u16 data16;
+// -------------------------------------------------------------------------------------------------
+// Run the CPU up to the next scheduled event on whichever core matches the current accurate
+// emulation flags. We pick it fresh every time so any change to the flags (SAMS mapped in,
+// IDLE seen or a save state restored) switches cores right away.
+// -------------------------------------------------------------------------------------------------
+ITCM_CODE void TMS9900_RunUntilEvent(void)
+{
+    TMS9900_Cores[tms9900.accurateEmuFlags & (ACCURATE_EMU_IDLE | ACCURATE_EMU_TIMER | ACCURATE_EMU_SAMS)]();
+}
 
-        if (tms9900.cpuInt) TMS9900_HandlePendingInterrupts();
-        if (tms9900.PC == 0x40e8) HandleTICCSector();  // Disk access is not common but trap it here...
-        tms9900.currentOp = ReadPC16();
-        u8 op8 = (u8)OpcodeLookup[tms9900.currentOp];
+#ifdef TMS9900_MEM_STATS
+// -------------------------------------------------------------------------------------------------
+// Start a fresh measurement - all of the access counts go back to zero.
+// -------------------------------------------------------------------------------------------------
+void MemStats_Clear(void)
+{
+    memset(memStatsType, 0x00, sizeof(memStatsType));
+    memset(memStatsPage, 0x00, sizeof(memStatsPage));
+}
 
-        switch (op8)
+// -------------------------------------------------------------------------------------------------
+// Write the access counts since the last reset out to /data/DS994a.mem as plain text (one line per
+// memory class and then one line per 256 byte page that saw any traffic).
+// -------------------------------------------------------------------------------------------------
+void MemStats_Dump(void)
+{
+    extern u32 file_crc;
+
+    FILE *fp = fopen("/data/DS994a.mem", "w");
+    if (fp)
+    {
+        fprintf(fp, "GAME CRC %08X\n\n", (unsigned int)file_crc);
+        fprintf(fp, "%-8s %10s %10s %10s\n", "TYPE", "READ", "WRITE", "FETCH");
+        for (u8 type=0; type <= MF_UNUSED; type++)
         {
-        #include "tms9900.inc"
+            fprintf(fp, "%-8s %10u %10u %10u\n", memStatsTypeName[type], (unsigned int)memStatsType[MEM_STAT_READ][type],
+                    (unsigned int)memStatsType[MEM_STAT_WRITE][type], (unsigned int)memStatsType[MEM_STAT_FETCH][type]);
         }
-    }
-    while(tms9900.cycles < myCounter);    // There are 191 CPU clocks per line on the TI
 
-    tms9900.cycleDelta = tms9900.cycles-myCounter;
+        fprintf(fp, "\n%-8s %-8s %10s %10s %10s\n", "PAGE", "TYPE", "READ", "WRITE", "FETCH");
+        for (u16 page=0; page < 256; page++)
+        {
+            if (memStatsPage[MEM_STAT_READ][page] | memStatsPage[MEM_STAT_WRITE][page] | memStatsPage[MEM_STAT_FETCH][page])
+            {
+                fprintf(fp, ">%02X00    %-8s %10u %10u %10u\n", page, memStatsTypeName[MemType[page<<4]], (unsigned int)memStatsPage[MEM_STAT_READ][page],
+                        (unsigned int)memStatsPage[MEM_STAT_WRITE][page], (unsigned int)memStatsPage[MEM_STAT_FETCH][page]);
+            }
+        }
+        fclose(fp);
+    }
 }
+#endif
 
 // End of file
@@ -104,10 +104,15 @@ extern u8   MemGROM[];
 extern u8   DiskDSR[];
 extern u16  BankMasks[];
 extern u8   MemType[0x10000>>4];
+extern u8  *MemPageRead[256];
+extern u8  *MemPageWrite[256];
 
 extern u8 cart_cru_shadow[16];
 extern u8 super_bank;
 
+// The four 8K Super Cart RAM banks live in the back-end 32K of the cart buffer (bank 0 uses the slot below bank 3)
+#define SUPERCART_BANK_OFFSET(bank)     (MAX_CART_SIZE - (0x2000 * ((bank) ? (bank) : 4)))
+
 // ----------------------------------------------------------------------------
 // The entire state of the TMS9900 so we can easily save/load for save states.
 // ----------------------------------------------------------------------------
@@ -138,6 +143,12 @@ extern TMS9900 tms9900;
 
 #define WP_REG(x)  (tms9900.WP + ((x)<<1))  // Registers are every 16-bits from the WP... no bounds check so we assume program is well-behaved
 
+// ------------------------------------------------------------------------------------------------------------
+// The 256 bytes of scratchpad RAM are only partially decoded and so appear four times at >8000, >8100, >8200
+// and >8300. We only ever store the >8300 copy and fold any access to the other three onto it.
+// ------------------------------------------------------------------------------------------------------------
+#define SCRATCHPAD_FOLD(address)    ((((address) & 0xFC00) == 0x8000) ? ((address) | 0x0300) : (address))
+
 // --------------------------------------------
 // Some common cycle times for GROM access
 // --------------------------------------------
@@ -195,6 +206,41 @@ enum _STATUS_FLAGS
 #define ACCURATE_EMU_TIMER      0x02
 #define ACCURATE_EMU_SAMS       0x04
 
+// --------------------------------------------------------------------------------------------------
+// With threaded dispatch, each opcode handler jumps directly to the handler for the next opcode
+// using GCC labels-as-values rather than going back through the single shared switch() jump. Comment
+// this out to fall back to the plain switch() dispatch (useful for debugging or non-GCC compilers).
+// --------------------------------------------------------------------------------------------------
+#define TMS9900_THREADED_DISPATCH
+
+// --------------------------------------------------------------------------------------------------
+// With lazy flags, the ALU instructions don't rebuild the L> A> EQ status bits - they just record
+// the result (and the second operand for the compare instructions) and the bits are derived only
+// when something needs them: a conditional jump tests the recorded result directly while STST,
+// context switches and save states materialize the full ST word. Comment this out to go back to
+// the eager Classic99 style table lookups on every instruction.
+// --------------------------------------------------------------------------------------------------
+#define TMS9900_LAZY_FLAGS
+
+// --------------------------------------------------------------------------------------------------
+// Memory access instrumentation for tuning a slow title. Uncomment this to count every access made
+// through MemoryRead16/8(), MemoryWrite16/8() and the PC fetch (decode cache hits included) both by
+// MemType[] class and by 256 byte page, split into read/write/fetch. The counts show up on an extra
+// debugger page and leaving that page writes them out to the SD card. Workspace register accesses
+// (ReadWP_RAM16 and friends) are not counted. Leave this commented out for release builds - nothing
+// of it is compiled in then.
+// --------------------------------------------------------------------------------------------------
+//#define TMS9900_MEM_STATS
+
+typedef struct _LazyStatus
+{
+    u16     result;     // The last result - L> A> EQ come from comparing this against 'operand'
+    u16     operand;    // Zero for everything except the C, CB and CI compare instructions
+    u16     pending;    // Non-zero when the L> A> EQ bits in tms9900.ST are stale and must be derived from the above
+} LazyStatus;
+
+extern LazyStatus lazyST;
+
 // --------------------------------------------------------
 // Interrupt Masks... we only handle VDP and Timer
 // --------------------------------------------------------
@@ -239,14 +285,38 @@ enum _MEM_TYPE
     MF_UNUSED,      // This is some unused memory space... will return 0xFF (or, really, whatever was left in the MemCPU[] buffer at that address)
 };
 
+#ifdef TMS9900_MEM_STATS
+#define MEM_STAT_READ           0
+#define MEM_STAT_WRITE          1
+#define MEM_STAT_FETCH          2
+
+extern u32 memStatsType[3][MF_UNUSED+1];
+extern u32 memStatsPage[3][256];
+extern const char *memStatsTypeName[MF_UNUSED+1];
+extern void MemStats_Clear(void);
+extern void MemStats_Dump(void);
+
+#define MEM_STAT(kind, address) {memStatsType[kind][MemType[(address)>>4]]++; memStatsPage[kind][(address)>>8]++;}
+#else
+#define MEM_STAT(kind, address)
+#endif
+
 extern void TMS9900_Reset(void);
 extern void TMS9900_Run(void);
+extern void TMS9900_RunIdle(void);
+extern void TMS9900_RunSAMS(void);
 extern void TMS9900_RunAccurate(void);
+extern void TMS9900_RunUntilEvent(void);
 extern void TMS9900_Kickoff(void);
 extern void TMS9900_RaiseInterrupt(u16 iMask);
 extern void TMS9900_ClearInterrupt(u16 iMask);
 extern void TMS9900_SetAccurateEmulationFlag(u16 flag);
 extern void TMS9900_ClearAccurateEmulationFlag(u16 flag);
+extern void TMS9900_FlushDecodeCache(void);
+extern void TMS9900_SyncStatus(void);
+extern void TMS9900_MapPages(u16 address, u32 size);
+extern void TMS9900_MapCart(void);
+extern void TMS9900_MapSAMS(u8 region);
 extern u32  SAMS_Read32(u32 address);
 extern void SAMS_Write32(u32 address, u32 data);
 extern void SAMS_MapDSR(u8 dataBit);
@@ -254,5 +324,6 @@ extern void SAMS_cru_write(u16 address, u8 dataBit);
 extern void cart_cru_write(u16 cruAddress, u8 dataBit);
 extern u8   cart_cru_read(u16 cruAddress);
 extern void WriteBankMBX(u8 bank);
+extern void WriteBankSuperCart(u8 bank);
 
 #endif
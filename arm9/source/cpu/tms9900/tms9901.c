@@ -22,6 +22,7 @@
 #include "../../disk.h"
 #include "../../pcode.h"
 #include "../../SAMS.h"
+#include "../../scheduler.h"
 
 // From https://www.unige.ch/medecine/nouspikel/ti99/tms9901.htm
 //
@@ -92,9 +93,47 @@ void TMS9901_Reset(void)
     // -------------------------------------------------------------------------------------------------------------------
     tms9901.PinState[PIN_TIMER_OR_IO]  =  IO_MODE;
 
+    Scheduler_Cancel(EVT_TIMER9901);
+
     TMS9900_ClearInterrupt(0xFFFF);
 }
 
+// -----------------------------------------------------------------------------------------
+// The timer decrements once every 64 CPU clocks but only while we are in IO mode. Rather
+// than counting it down as we go, we schedule an event for when it will reach zero and
+// only work out the counter value when someone needs to see it (entering timer mode where
+// the counter can be read back, or a save state).
+// -----------------------------------------------------------------------------------------
+void TMS9901_TimerSync(void)
+{
+    if (EVENT_ACTIVE(EVT_TIMER9901))
+    {
+        s32 left = (s32)(sched.when[EVT_TIMER9901] - tms9900.cycles);
+        tms9901.TimerCounter = (left > TIMER_TICK_CYCLES) ? ((left + TIMER_TICK_CYCLES - 1) / TIMER_TICK_CYCLES) : 1;
+    }
+}
+
+// Start (or stop) the timer counting down from the current counter value based on the mode we are in
+void TMS9901_TimerRun(void)
+{
+    if (tms9901.TimerCounter && (tms9901.PinState[PIN_TIMER_OR_IO] == IO_MODE))
+    {
+        Scheduler_Add(EVT_TIMER9901, tms9900.cycles + (tms9901.TimerCounter * TIMER_TICK_CYCLES));
+    }
+    else
+    {
+        Scheduler_Cancel(EVT_TIMER9901);
+    }
+}
+
+// The timer reached zero at CPU cycle 'due' - raise the interrupt and reload the timer to go again
+void TMS9901_TimerExpired(u32 due)
+{
+    TMS9901_RaiseTimerInterrupt();
+    tms9901.TimerCounter = tms9901.TimerStart;
+    if (tms9901.TimerCounter) Scheduler_Add(EVT_TIMER9901, due + (tms9901.TimerCounter * TIMER_TICK_CYCLES));
+}
+
 // -----------------------------------------------------------------------------------------
 // Write up to 16 bits of information to the CRU. This routine handles the data shifting
 // as needed to clock out one or more bits (up to the full 16 bits) to the CRU. The CPU
@@ -161,7 +200,9 @@ ITCM_CODE void TMS9901_WriteCRU(u16 cruAddress, u16 data, u8 num)
             // -------------------------------------------------------------------------------------------------
             if (cruA == PIN_TIMER_OR_IO)
             {
+                TMS9901_TimerSync();    // Freeze the counter where it is now...
                 tms9901.PinState[PIN_TIMER_OR_IO] = (dataBit ? TIMER_MODE : IO_MODE);
+                TMS9901_TimerRun();     // ...and let it run again if we're back in IO mode
             }
             else
             if (tms9901.PinState[PIN_TIMER_OR_IO] == TIMER_MODE)
@@ -177,6 +218,7 @@ ITCM_CODE void TMS9901_WriteCRU(u16 cruAddress, u16 data, u8 num)
 	                tms9901.PinState[3]=0;	// timer interrupt mask
 	                tms9901.TimerCounter=0; // timer counter
                     tms9901.TimerStart=0;   // timer start
+                    TMS9901_TimerRun();     // Which stops the timer
                 }
                 else if ((cruA >= 1) && (cruA <= 14))    // Bits 1-14 represent the the 14 bit counter/timer ...
                 {
@@ -189,6 +231,7 @@ ITCM_CODE void TMS9901_WriteCRU(u16 cruAddress, u16 data, u8 num)
                 else if (cruA > 15)
                 {
                     tms9901.PinState[PIN_TIMER_OR_IO] = IO_MODE;        // Writes to pin 16 or more result in exit back to IO mode
+                    TMS9901_TimerRun();                                 // And the timer starts counting down
                 }
             }
             else    // We're in I/O Mode
@@ -56,6 +56,8 @@ enum PIN_STATE
 #define PIN_COL3            20
 #define PIN_ALPHA_LOCK      21
 
+#define TIMER_TICK_CYCLES   64      // The 9901 timer decrements once every 64 CPU clocks
+
 typedef struct _TMS9901
 {
     u8      Keyboard[TMS_KEY_MAX];      // Main TI-99/4a Keyboard plus joystick inputs for both P1 and P2
@@ -77,5 +79,8 @@ extern void     TMS9901_RaiseVDPInterrupt(void);
 extern void     TMS9901_ClearVDPInterrupt(void);
 extern void     TMS9901_RaiseTimerInterrupt(void);
 extern void     TMS9901_ClearTimerInterrupt(void);
+extern void     TMS9901_TimerSync(void);
+extern void     TMS9901_TimerRun(void);
+extern void     TMS9901_TimerExpired(u32 due);
 
 #endif //TMS9901_H_
@@ -59,13 +59,11 @@ u8 XBuf_B[256*192] ALIGN(32) = {0}; // Screen is 256x192. Ping Pong Buffer B
 u8 *XBuf __attribute__((section(".dtcm"))) = XBuf_A;
 
 u32 lutTablehh[256][16];    // Look up table for colors - pre-generated for maximum speed!
-u32 fastBackgroundLut[256] __attribute__((section(".dtcm"))); // For when the color is background - happens often enough
 
 u8 OH __attribute__((section(".dtcm"))) = 0;
 u8 IH __attribute__((section(".dtcm"))) = 0;
 
-u8 scan_collisions_every __attribute__((section(".dtcm"))) = 32;
-u8 CollisionCheckEvery[] = {255, 4, 8, 16, 32, 64, 255};
+u16 spriteDouble[256];      // Each bit of a byte doubled up - the pixel coverage of a zoomed sprite
 
 // ---------------------------------------------------------------------------------------
 // Screen handlers and masks for VDP table address registers.
@@ -118,99 +116,66 @@ u16 ChrGenM     __attribute__((section(".dtcm"))) = 0x3FFF;
 u16 SprTabM     __attribute__((section(".dtcm"))) = 0x3FFF;
 
 
-/** CheckSprites() ***********************************************/
-/** This function is periodically called to check for sprite    **/
-/** collisions. The caller of this will set the flag as needed. **/
-/** Returning zero (0) means no collision. Otherwise collision. **/
-/*****************************************************************/
-ITCM_CODE byte CheckSprites(void)
+// ----------------------------------------------------------------------------------------
+// Sprite line lists - rather than walk all 32 sprites for every line we sort the sprites
+// into the lines they cover whenever the sprite attribute table (or the sprite size or
+// table address) changes, which for most games is once a frame at most. Each line gets
+// the mask of sprites to draw and the 5th sprite number (-1 if there isn't one).
+// ----------------------------------------------------------------------------------------
+u32 spriteLineMask[192];                                            // Sprites to draw on each line
+s8  spriteLineFifth[192];                                           // The 5th sprite on each line (-1 if none)
+u8  spriteLast __attribute__((section(".dtcm"))) = 31;              // The last sprite scanned - the one with Y==208 or else sprite 31
+u32 spriteListGen __attribute__((section(".dtcm"))) = 0;            // The vdpGen the lists were built at (0 means they must be rebuilt)
+
+static void SpriteListBuild(void)
 {
-  unsigned int I,J,LS,LD;
-  byte *S,*D,*PS,*PD,*T;
-  int DH,DV;
+    static u8 count[192];
+    byte *AT = SprTab;
+    u8 MS = MaxSprites[myConfig.maxSprites];    // We either render 4 sprites (normal - this is how an 9918 would work) or 32 sprites (enhanded mode for emulation only)
 
-  /* Find valid, displayed sprites */
-  DV = TMS9918_Sprites16 ? -16:-8;
-  for(I=J=0,S=SprTab;(I<32)&&(S[0]!=208);++I,S+=4)
-  {
-    if(((S[0]<191)||(S[0]>255+DV))&&((int)S[1]-(S[3]&0x80? 32:0)>DV))  J|=1<<I;
-  }
+    memset(spriteLineMask, 0x00, sizeof(spriteLineMask));
+    memset(spriteLineFifth, -1, sizeof(spriteLineFifth));
+    memset(count, 0x00, sizeof(count));
+    spriteLast = 31;
 
-  // ------------------------------------------------------------------
-  // Run through all displayed sprites and see if there is any overlap.
-  // This is a bit CPU intensive - we check vertical overlap first as
-  // it's a bit faster to see if these have any chance of collision.
-  // ------------------------------------------------------------------
-  if(TMS9918_Sprites16)
-  {
-    for(S=SprTab;J;J>>=1,S+=4)
-      if(J&1)
-        for(I=J>>1,D=S+4;I;I>>=1,D+=4)
-          if(I&1)
-          {
-            DV=(int)S[0]-(int)D[0]; // Check if these sprites might coincide vertically
-            if((DV<16)&&(DV>-16))
-            {
-              DH=(int)S[1]-(int)D[1]-(S[3]&0x80? 32:0)+(D[3]&0x80? 32:0);
-              if((DH<16)&&(DH>-16)) // Check if these sprites might coincide horizontally
-              {
-                PS=SprGen+((int)(S[2]&0xFC)<<3);
-                PD=SprGen+((int)(D[2]&0xFC)<<3);
-                if(DV>0) PD+=DV; else { DV=-DV;PS+=DV; }
-                if(DH<0) { DH=-DH;T=PS;PS=PD;PD=T; }
-                while(DV<16)
-                {
-                  LS=((unsigned int)PS[0]<<8)+PS[16];
-                  LD=((unsigned int)PD[0]<<8)+PD[16];
-                  if(LD&(LS>>DH)) break;
-                  else { ++DV;++PS;++PD; }
-                }
-                if(DV<16) return(1);
-              }
-            }
-          }
-  }
-  else
-  {
-    for(S=SprTab;J;J>>=1,S+=4)
-      if(J&1)
-        for(I=J>>1,D=S+4;I;I>>=1,D+=4)
-          if(I&1)
-          {
-            DV=(int)S[0]-(int)D[0];
-            if((DV<8)&&(DV>-8))
-            {
-              DH=(int)S[1]-(int)D[1]-(S[3]&0x80? 32:0)+(D[3]&0x80? 32:0);
-              if((DH<8)&&(DH>-8))
-              {
-                PS=SprGen+((int)S[2]<<3);
-                PD=SprGen+((int)D[2]<<3);
-                if(DV>0) PD+=DV; else { DV=-DV;PS+=DV; }
-                if(DH<0) { DH=-DH;T=PS;PS=PD;PD=T; }
-                while((DV<8)&&!(*PD&(*PS>>DH))) { ++DV;++PS;++PD; }
-                if(DV<8) return(1);
-              }
-            }
-          }
-  }
+    for (u8 sprite=0; sprite<32; sprite++, AT+=4)
+    {
+        s16 K = AT[0];                          // K = sprite Y coordinate
+        if (K == 208) {spriteLast = sprite; break;} // Iteration terminates if Y=208 and we save the last scanned sprite
+        if (K > 256-IH) K -= 256;               // Y coordinate may be negative
 
-  /* No collision */
-  return(0);
-}
+        // -------------------------------------------------------------------------------------------
+        // The sprite is on every line Y where (Y>K) && (Y<=K+OH). At first this looked wrong as if it
+        // was off by 1 for comparing the Y (scanline) number with the sprite Y coordinate but the Y
+        // position is tricky. A coordinate of 0 means draw at the first pixel line (one below the
+        // top-most pixel line of the screen). A 255 means draw at the 0th top-most pixel line of the
+        // screen. Y positions below 255 but above 208 are negative indexes which allow for the sprite
+        // to be positioned partially cropped at the top. Finally, the reason 208 was chosen by TI as
+        // the sentinal value is that it's 16 pixels below the lowest pixel row of 192 and the sprite
+        // would be completely off-screen. Tricky...
+        // -------------------------------------------------------------------------------------------
+        s16 first = (K+1 < 0) ? 0 : K+1;
+        s16 last  = (K+OH > 191) ? 191 : K+OH;
+
+        for (s16 Y=first; Y<=last; Y++)
+        {
+            u8 n = ++count[Y];
+            if (n == 5)  spriteLineFifth[Y] = sprite;       // The 5th sprite on the line
+            if (n <= MS) spriteLineMask[Y] |= (1<<sprite);  // Mark sprite as ready to draw (up to the maximum per line)
+        }
+    }
 
+    spriteListGen = vdpGen;
+}
 
 /** ScanSprites() ********************************************/
 /** Compute bitmask of sprites shown in a given scanline.   **/
-/** Returns the last sprite to be scanned or -1 if none.    **/
+/** Returns the highest sprite shown or -1 if none.         **/
 /** Also updates 5th sprite fields in the status register.  **/
 /*************************************************************/
 ITCM_CODE int ScanSprites(byte Y, unsigned int *Mask)
 {
-    byte *AT;
-    u8 sprite,MS,S5;
-    s16 K;
-
-    // Assume no sprites shown - we OR in a '1' for each visible sprite
+    // Assume no sprites shown
     *Mask = 0x00000000;
 
     // Must have MODE1+ and screen enabled - otherwise no sprites rendered
@@ -219,43 +184,16 @@ ITCM_CODE int ScanSprites(byte Y, unsigned int *Mask)
         return(-1);
     }
 
-    s16 fifth_sprite_num =-1;                   // Used to detect the 5th sprite on a line
-    AT = SprTab;                                // Pointer to the sprite table in VDP memory
-    MS = MaxSprites[myConfig.maxSprites]+1;     // We either render 4 sprites (normal - this is how an 9918 would work) or 32 sprites (enhanded mode for emulation only)
-    S5 = 5;                                     // We always want to trap on the 5th sprite
-    u8 last = 31;                               // The last sprite number is 31 but we may break early if Y==208
-
-    // ------------------------------------------------------------------
-    // Scan through all possible 32 sprites to see what's being shown...
-    // ------------------------------------------------------------------
-    for(sprite=0;sprite<32;++sprite,AT+=4)
-    {
-        K=AT[0];                            // K = sprite Y coordinate
-        if(K==208) {last=sprite; break;}    // Iteration terminates if Y=208 and we save the last scanned sprite
-        if(K>256-IH) K-=256;                // Y coordinate may be negative
-
-        // -------------------------------------------------------------------------------------------
-        // Mark all valid sprites with 1s, break at MaxSprites. Track last scanned sprite for 5S num
-        // At first this looked wrong as if it was off by 1 for comparing the Y (scanline) number
-        // with the sprite Y coordinate but the Y position is tricky. A coordinate of 0 means draw
-        // at the first pixel line (one below the top-most pixel line of the screen). A 255 means
-        // draw at the 0th top-most pixel line of the screen. Y positions below 255 but above 208 are
-        // negative indexes which allow for the sprite to be positioned partially cropped at the top.
-        // Finally, the reason 208 was chosen by TI as the sentinal value is that it's 16 pixels below
-        // the lowest pixel row of 192 and the sprite would be completely off-screen. Tricky...
-        // -------------------------------------------------------------------------------------------
-        if((Y>K)&&(Y<=K+OH))
-        {
-            // If we exceed four sprites per line, set 5th sprite number
-            if(!--S5) fifth_sprite_num = sprite;
-
-            // If we exceed maximum number of sprites per line, stop here
-            if(!--MS) break;
+    // Rebuild the line lists if the sprite attribute table has been written since they were built
+    u32 *satGen = &vramRegionGen[(SprTab - pVDPVidMem) >> VRAM_REGION_SHIFT];
+    u32 newest = satGen[0];
+    if (satGen[1] > newest) newest = satGen[1];
+    if (satGen[2] > newest) newest = satGen[2];
+    if (satGen[3] > newest) newest = satGen[3];
+    if ((newest > spriteListGen) || !spriteListGen) SpriteListBuild();
 
-            // Mark sprite as ready to draw
-            *Mask |= (1<<sprite);
-        }
-    }
+    *Mask = spriteLineMask[Y];
+    s8 fifth_sprite_num = spriteLineFifth[Y];
 
     // ------------------------------------------------------------------------
     // The if a 5th  sprite was found on this line, we check to see if we've
@@ -272,30 +210,40 @@ ITCM_CODE int ScanSprites(byte Y, unsigned int *Mask)
         else // This is undocumented behavior but a real VDP will behave like this and Miner 2049er will rely on it
         {
             VDPStatus &= ~TMS9918_STAT_5THNUM;      // Clear out any previous sprite number
-            VDPStatus |= last;                      // Set the 5th sprite number to the last scanned sprite on the line (the one with Y==208 or else sprite 31)
+            VDPStatus |= spriteLast;                // Set the 5th sprite number to the last scanned sprite on the line (the one with Y==208 or else sprite 31)
         }
     }
 
-  // Return last scanned sprite - the caller's Mask is also filled in with a list of all shown sprites
-  return(sprite-1);
+  // Return the highest sprite shown - the caller's Mask is also filled in with a list of all shown sprites
+  return(*Mask ? (31 - __builtin_clz(*Mask)) : -1);
 }
 
 
 /** RefreshSprites() *****************************************/
-/** This function is called from RefreshLine#() to refresh  **/
-/** and draw sprites to a given pixel line.                 **/
+/** This function is called after RefreshLine#() to draw    **/
+/** sprites to a given pixel line. N and M are the last     **/
+/** sprite and mask as returned by ScanSprites() for Y.     **/
+/** Sprite collisions are found here too - as each sprite   **/
+/** is drawn its pixels are ORed into a coverage mask for   **/
+/** the line and any overlap sets the collision flag. For   **/
+/** lines that aren't being drawn, we're called with Draw   **/
+/** clear and just do the collision check.                  **/
 /*************************************************************/
-ITCM_CODE void RefreshSprites(register byte Y)
+ITCM_CODE void RefreshSprites(register byte Y, register int N, unsigned int M, u8 Draw)
 {
   register byte *PT,*AT;
   register byte *P,*T,C;
-  register int L,K,N;
-  unsigned int M;
+  register int L,K,H,D;
+  u32 S,W0,W1,Cover[9];
+  u8 Collide;
 
-  /* Find sprites to show, update 5th sprite status */
-  N = ScanSprites(Y,&M);
   if((N<0) || !M) return;
 
+  /* Only two or more sprites can collide and once the flag is set it stays set until read */
+  Collide = (M&(M-1)) && !(VDPStatus&TMS9918_STAT_OVRLAP);
+  if(!Draw && !Collide) return;
+  if(Collide) memset(Cover,0x00,sizeof(Cover));
+
   T  = XBuf+256*Y;
   AT = SprTab+(N<<2);
 
@@ -309,7 +257,8 @@ ITCM_CODE void RefreshSprites(register byte Y)
       L=C&0x80? AT[1]-32:AT[1]; /* Sprite may be shifted left by 32 */
       C&=0x0F;                  /* C = sprite color */
 
-      if((L<256) && (L>-OH) && C)
+      /* Transparent sprites are not drawn but they still collide */
+      if((L<256) && (L>-OH) && ((C && Draw) || Collide))
       {
         K=AT[0];                /* K = sprite Y coordinate */
         if(K>256-IH) K-=256;    /* Y coordinate may be negative */
@@ -319,9 +268,35 @@ ITCM_CODE void RefreshSprites(register byte Y)
         PT = SprGen
            + ((int)(IH>8? (AT[2]&0xFC):AT[2])<<3)
            + (OH>IH? (K>>1):K);
+        D  = ((int)PT[0]<<8)|(IH>8? PT[16]:0x00);
 
-        /* Mask 1: clip left sprite boundary */
-        K=L>=0? 0xFFFF:(0x10000>>(OH>IH? (-L>>1):-L))-1;
+        /* Collision: place the sprite pixels (MSB leftmost) in the coverage mask for the line */
+        if(Collide && D)
+        {
+          S = OH>IH? (((u32)spriteDouble[D>>8]<<16)|spriteDouble[D&0xFF]):((u32)D<<16);
+          if(L<0) { K=0; W0=S<<-L; W1=0; }
+          else
+          {
+            K=L>>5; W0=S>>(L&31); W1=(L&31)? (S<<(32-(L&31))):0;
+            if(K==7) W1=0;      /* Nothing past the right edge of the screen */
+          }
+          if((Cover[K]&W0) || (Cover[K+1]&W1))
+          {
+            VDPStatus|=TMS9918_STAT_OVRLAP;
+            Collide=0;
+          }
+          Cover[K]|=W0; Cover[K+1]|=W1;
+        }
+
+        if(!C || !Draw) continue;
+
+        /* Mask 1: clip left sprite boundary - a zoomed sprite at an odd negative */
+        /* X has just the right half of one pixel pair showing (H) and we must   */
+        /* not draw the left half into the end of the line above                 */
+        H=0;
+        if(L>=0) K=0xFFFF;
+        else if(OH>IH) { K=(0x10000>>((1-L)>>1))-1; if(L&1) H=0x8000>>(-L>>1); }
+        else K=(0x10000>>-L)-1;
 
         /* Mask 2: clip right sprite boundary */
         L+=(int)OH-257;
@@ -332,7 +307,8 @@ ITCM_CODE void RefreshSprites(register byte Y)
         }
 
         /* Get and clip the sprite data */
-        K&=((int)PT[0]<<8)|(IH>8? PT[16]:0x00);
+        if(D&H) T[0]=C;
+        K&=D;
 
         if(OH>IH)
         {
@@ -459,13 +435,96 @@ ITCM_CODE void RefreshLine0(u8 Y)
   }
 }
 
+// ----------------------------------------------------------------------------------------
+// Pattern cache for Graphics I and II. Each character row of the pattern table is kept
+// fully expanded to its 8 pixels in the colours from the colour table so drawing a cell
+// is just two 32-bit stores. There is a set of 256 characters for each third of the
+// screen (Graphics I only uses the first). A character is expanded the first time it is
+// drawn and stays valid until the pattern or colour bytes it came from are written - we
+// find those using the VRAM write generations. The whole third is checked, but only
+// when something has changed in its pattern or colour table since the last check.
+// ----------------------------------------------------------------------------------------
+u32 patternCache[3][256*8][2] ALIGN(32);                                     // Expanded pixels for each character row (third, char*8+row)
+u8  patternValid[3][256];                                                    // Non-zero if the character has been expanded and is still good
+u32 patternCacheGen[3] __attribute__((section(".dtcm"))) = {0};             // The vdpGen each third was last checked at
+
+// The pattern and colour table addresses of character c in a given third - the rows of a character are always in the same 32 byte region
+#define PAT_ADDR2(third,c)  ((ChrGen - pVDPVidMem) + ((((third)<<11) | ((c)<<3)) & ChrGenM))
+#define COL_ADDR2(third,c)  ((ColTab - pVDPVidMem) + ((((third)<<11) | ((c)<<3)) & ColTabM))
+#define PAT_ADDR1(c)        ((ChrGen - pVDPVidMem) + ((c)<<3))
+#define COL_ADDR1(c)        ((ColTab - pVDPVidMem) + ((c)>>3))
+
+// ----------------------------------------------------------------------------------------
+// Throw out any characters in this third whose pattern or colour bytes have changed
+// since we last looked (or all of them if the VDP registers have changed).
+// ----------------------------------------------------------------------------------------
+static void PatternCacheCheck(u8 third)
+{
+    u32 since = patternCacheGen[third];
+    u8 *valid = patternValid[third];
+
+    if (vdpRegGen > since)
+    {
+        memset(valid, 0x00, 256);
+    }
+    else if (ScrMode == 2)
+    {
+        for (u16 c=0; c<256; c++)
+        {
+            if ((vramRegionGen[PAT_ADDR2(third,c) >> VRAM_REGION_SHIFT] > since) || (vramRegionGen[COL_ADDR2(third,c) >> VRAM_REGION_SHIFT] > since)) valid[c] = 0;
+        }
+    }
+    else
+    {
+        for (u16 c=0; c<256; c++)
+        {
+            if ((vramRegionGen[PAT_ADDR1(c) >> VRAM_REGION_SHIFT] > since) || (vramRegionGen[COL_ADDR1(c) >> VRAM_REGION_SHIFT] > since)) valid[c] = 0;
+        }
+    }
+
+    patternCacheGen[third] = vdpGen;
+}
+
+// ----------------------------------------------------------------------------------------
+// Expand all 8 rows of a character into the cache - they'll be wanted for the next
+// 7 lines too as the character is in the same name table row.
+// ----------------------------------------------------------------------------------------
+ITCM_CODE static void PatternCacheFill(u8 third, u8 c)
+{
+    u32 *dest = patternCache[third][c<<3];
+    u8 *pat, *col;
+    u8 colStep;
+
+    if (ScrMode == 2)
+    {
+        pat = pVDPVidMem + PAT_ADDR2(third,c);
+        col = pVDPVidMem + COL_ADDR2(third,c);
+        colStep = 1;    // One colour byte per pixel row
+    }
+    else
+    {
+        pat = pVDPVidMem + PAT_ADDR1(c);
+        col = pVDPVidMem + COL_ADDR1(c);
+        colStep = 0;    // One colour byte for all rows of 8 characters
+    }
+
+    for (u8 row=0; row<8; row++)
+    {
+        u8 K = *pat++;
+        *dest++ = lutTablehh[*col][K>>4];
+        *dest++ = lutTablehh[*col][K&0xF];
+        col += colStep;
+    }
+
+    patternValid[third][c] = 1;
+}
+
 /** RefreshLine1() *******************************************/
-/** Refresh line Y (0..191) of SCREEN1, including sprites   **/
-/** in this line.                                           **/
+/** Refresh line Y (0..191) of SCREEN1. The sprites on the  **/
+/** line are drawn over it by RenderLine().                 **/
 /*************************************************************/
 ITCM_CODE void RefreshLine1(u8 uY)
 {
-  register byte K=0,Offset,BC;
   register u8 *T;
   register u32 *P;
   u8 lastT;
@@ -478,7 +537,14 @@ ITCM_CODE void RefreshLine1(u8 uY)
   else
   {
     T=ChrTab+((int)(uY&0xF8)<<2);
-    Offset=uY&0x07;
+
+    u32 tables = vramBlockGen[(ChrGen - pVDPVidMem) >> VRAM_BLOCK_SHIFT];
+    u32 colour = vramRegionGen[(ColTab - pVDPVidMem) >> VRAM_REGION_SHIFT];
+    if (colour > tables) tables = colour;
+    if ((tables > patternCacheGen[0]) || (vdpRegGen > patternCacheGen[0])) PatternCacheCheck(0);
+
+    u32 *cache = patternCache[0][uY&0x07];
+    u8 *valid = patternValid[0];
 
     lastT = ~(*T);
 
@@ -487,28 +553,25 @@ ITCM_CODE void RefreshLine1(u8 uY)
       if (lastT != *T) // Is this set of pixels different than the last one?
       {
           lastT=*T;
-          BC=ColTab[lastT>>3];
-          K=ChrGen[((int)lastT<<3)+Offset];
-          ptLow  = lutTablehh[BC][K>>4];
-          ptHigh = lutTablehh[BC][K&0xF];
+          if (!valid[lastT]) PatternCacheFill(0, lastT);
+          ptLow  = cache[(lastT<<4)+0];
+          ptHigh = cache[(lastT<<4)+1];
       }
       *P++ = ptLow;
       *P++ = ptHigh;
       T++;
     }
-    RefreshSprites(uY);
   }
 }
 
 /** RefreshLine2() *******************************************/
-/** Refresh line Y (0..191) of SCREEN2, including sprites   **/
-/** in this line.                                           **/
+/** Refresh line Y (0..191) of SCREEN2. The sprites on the  **/
+/** line are drawn over it by RenderLine().                 **/
 /*************************************************************/
 ITCM_CODE void RefreshLine2(u8 uY)
 {
   u32 *P;
-  register byte K,BC,*T;
-  u16 J,I;
+  register byte *T;
 
   P=(u32*)(XBuf+(uY<<8));
 
@@ -517,8 +580,16 @@ ITCM_CODE void RefreshLine2(u8 uY)
   else
   {
     u32 ptLow = 0; u32 ptHigh = 0;
+    u8 third = uY>>6;
+
+    u32 tables = vramBlockGen[PAT_ADDR2(third,0) >> VRAM_BLOCK_SHIFT];
+    u32 colour = vramBlockGen[COL_ADDR2(third,0) >> VRAM_BLOCK_SHIFT];
+    if (colour > tables) tables = colour;
+    if ((tables > patternCacheGen[third]) || (vdpRegGen > patternCacheGen[third])) PatternCacheCheck(third);
+
+    u32 *cache = patternCache[third][uY&0x07];
+    u8 *valid = patternValid[third];
 
-    J   = ((u16)((u16)uY&0xC0)<<5)+(uY&0x07);
     T   = ChrTab+((u16)((u16)uY&0xF8)<<2);
     u8 lastT = ~(*T);
 
@@ -527,31 +598,20 @@ ITCM_CODE void RefreshLine2(u8 uY)
       if (lastT != *T) // Is this set of pixels different than the last one?
       {
           lastT = *T;
-          I     = (u16)lastT<<3;
-          BC    = ColTab[(J+I)&ColTabM];
-          K     = ChrGen[(J+I)&ChrGenM];
-          if (K)
-          {
-              ptLow  = lutTablehh[BC][K>>4];
-              ptHigh = lutTablehh[BC][K&0xF];
-          }
-          else // It's all background
-          {
-              ptLow = ptHigh = fastBackgroundLut[BC];
-          }
+          if (!valid[lastT]) PatternCacheFill(third, lastT);
+          ptLow  = cache[(lastT<<4)+0];
+          ptHigh = cache[(lastT<<4)+1];
       }
       *P++ = ptLow;
       *P++ = ptHigh;
       T++;
     }
-
-    RefreshSprites(uY);
   }
 }
 
 /** RefreshLine3() *******************************************/
-/** Refresh line Y (0..191) of SCREEN3, including sprites   **/
-/** in this line.                                           **/
+/** Refresh line Y (0..191) of SCREEN3. The sprites on the  **/
+/** line are drawn over it by RenderLine().                 **/
 /*************************************************************/
 ITCM_CODE void RefreshLine3(u8 uY)
 {
@@ -591,7 +651,6 @@ ITCM_CODE void RefreshLine3(u8 uY)
       }
       P+=8;T++;
     }
-    RefreshSprites(uY);
   }
 }
 
@@ -602,12 +661,18 @@ ITCM_CODE void RefreshLine3(u8 uY)
 u8 VDP_RegisterMasks[] __attribute__((section(".dtcm"))) = { 0x03, 0xfb, 0x0f, 0xff, 0x07, 0x7f, 0x07, 0xff };
 byte SprHeights[4] __attribute__((section(".dtcm"))) = { 8,16,16,32 };
 
+extern u16  batchLines;
+extern void ScanlineBatchCatchUp(void);
+
 ITCM_CODE byte Write9918(u8 iReg, u8 value)
 {
   u16 newMode;
   u16 VRAMMask;
   byte bIRQ;
 
+  /* Register writes are raster sensitive - make sure the lines already run by the CPU are rendered first */
+  if (batchLines) ScanlineBatchCatchUp();
+
   /* There are 8 VDP registers - map down to these 8 and mask off irrelevant bits */
   iReg &= 0x07;
   value &= VDP_RegisterMasks[iReg];
@@ -619,6 +684,12 @@ ITCM_CODE byte Write9918(u8 iReg, u8 value)
   VRAMMask = (iReg==1) && ((VDP[1]^value) & TMS9918_REG1_RAM16K) ? 0 : TMS9918_VRAMMask;  // Setting zero here forces re-computation of the VDP tables below
 
   /* Store value into the register */
+  if (VDP[iReg] != value)
+  {
+    vdpRegGen = ++vdpGen;
+    vdpDirty = 1;
+    if ((iReg == 1) || (iReg == 5)) spriteListGen = 0;  // Sprite size or attribute table moved - the sprite line lists must be rebuilt
+  }
   VDP[iReg]=value;
   
   /* Depending on the register, do... */
@@ -756,6 +827,8 @@ ITCM_CODE void WrCtrl9918(byte value)
 /*************************************************************/
 ITCM_CODE byte RdCtrl9918(void)
 {
+  if (batchLines) ScanlineBatchCatchUp();   /* Bring the collision and 5th sprite flags up to the current CPU cycle */
+
   byte data = VDPStatus;
   VDPStatus &= 0x1F; // Top bits are cleared on a read...
   VDPCtrlLatch = 0;
@@ -779,6 +852,179 @@ u16 tms_start_line __attribute__((section(".dtcm"))) = TMS9918_START_LINE;
 u16 tms_end_line   __attribute__((section(".dtcm"))) = TMS9918_END_LINE;
 u16 tms_cpu_line   __attribute__((section(".dtcm"))) = TMS9918_LINE;
 
+u8 vdpDirty  __attribute__((section(".dtcm"))) = 1;     // Non-zero when something that feeds the picture has changed (VRAM, VDP registers, disk DMA, state load)
+u8 vdpRedraw __attribute__((section(".dtcm"))) = 0;     // Full frames still to render before the picture is known to be stable
+u8 vdpRender __attribute__((section(".dtcm"))) = 0;     // Set when the current frame is being rendered (from the first change onwards)
+
+u32 vdpGen    __attribute__((section(".dtcm"))) = 1;    // Bumped on every change to VRAM or the VDP registers
+u32 vdpRegGen __attribute__((section(".dtcm"))) = 1;    // The generation of the last VDP register change (every line depends on these)
+u32 vramBlockGen[0x4000 >> VRAM_BLOCK_SHIFT] __attribute__((section(".dtcm"))) = {0};  // Generation of the last change in each 2K of VRAM
+u32 vramRegionGen[0x4000 >> VRAM_REGION_SHIFT] = {0};                                  // Generation of the last change in each 32 bytes of VRAM
+
+#define LINE_SPRITES    4   // Sprites on a line we can remember - a real VDP only shows 4 (lines with more are always redrawn)
+
+typedef struct
+{
+    u32 gen;                        // The vdpGen this line was drawn at (0 means it must be redrawn)
+    u32 sprMask;                    // Which sprites were drawn on the line
+    u32 sprAttr[LINE_SPRITES];      // And their 4 attribute bytes (position, pattern, colour)
+} tLineSig;
+
+tLineSig lineSig[2][192];           // One set for each of the ping-pong screen buffers
+
+// ----------------------------------------------------------------------------------------
+// Something other than the CPU has written this part of VRAM (e.g. disk sector DMA).
+// ----------------------------------------------------------------------------------------
+void VRAM_Changed(u16 addr, u16 len)
+{
+    if (len == 0) return;
+    u32 end = addr + len;
+    if (end > 0x4000) end = 0x4000;
+    vdpGen++;
+    for (u32 region = (addr >> VRAM_REGION_SHIFT); region <= ((end-1) >> VRAM_REGION_SHIFT); region++) vramRegionGen[region] = vdpGen;
+    for (u32 block = (addr >> VRAM_BLOCK_SHIFT); block <= ((end-1) >> VRAM_BLOCK_SHIFT); block++) vramBlockGen[block] = vdpGen;
+    vdpDirty = 1;
+}
+
+// ----------------------------------------------------------------------------------------
+// Everything on screen is suspect (VDP reset, save state restored) - redraw every line.
+// ----------------------------------------------------------------------------------------
+void VDP_Invalidate(void)
+{
+    vdpRegGen = ++vdpGen;
+    vdpDirty = 1;
+    spriteListGen = 0;
+}
+
+// ----------------------------------------------------------------------------------------
+// Start the generations over from scratch. Everything that remembers a generation is
+// cleared so every line is redrawn, the pattern cache and sprite lists are rebuilt and
+// nothing can look newer than the restarted counter. Used on a VDP reset and well before
+// vdpGen could wrap (a game rewriting a bitmap every frame would wrap it in a few hours).
+// ----------------------------------------------------------------------------------------
+void VDP_GenReset(void)
+{
+    memset(lineSig, 0x00, sizeof(lineSig));
+    memset(vramRegionGen, 0x00, sizeof(vramRegionGen));
+    memset(vramBlockGen, 0x00, sizeof(vramBlockGen));
+    memset(patternCacheGen, 0x00, sizeof(patternCacheGen));
+    memset(patternValid, 0x00, sizeof(patternValid));
+    spriteListGen = 0;
+    vdpGen = vdpRegGen = 1;
+    vdpDirty = 1;
+}
+
+// ----------------------------------------------------------------------------------------
+// The newest generation of anything in VRAM or the VDP registers that line Y is drawn
+// from - the name table row, the pattern and colour tables it indexes and the sprite
+// patterns if there are any sprites on the line. Only Graphics II splits the pattern
+// and colour tables into thirds - the other modes use the whole 2K pattern table.
+// ----------------------------------------------------------------------------------------
+static inline __attribute__((always_inline)) u32 LineSourceGen(u8 Y, u32 sprites)
+{
+    #define NEWER(g) if ((g) > gen) gen = (g)
+    u32 gen = vdpRegGen;
+    u16 row;
+
+    switch (ScrMode)
+    {
+        case 0: // Text - 40 characters per row so the row may straddle two regions
+            row = (ChrTab - pVDPVidMem) + (Y>>3)*40;
+            NEWER(vramRegionGen[row >> VRAM_REGION_SHIFT]);
+            NEWER(vramRegionGen[(row+39) >> VRAM_REGION_SHIFT]);
+            NEWER(vramBlockGen[(ChrGen - pVDPVidMem) >> VRAM_BLOCK_SHIFT]);
+            break;
+        case 1: // Graphics I - the 32 byte colour table is a single region
+            NEWER(vramRegionGen[((ChrTab - pVDPVidMem) + ((Y&0xF8)<<2)) >> VRAM_REGION_SHIFT]);
+            NEWER(vramBlockGen[(ChrGen - pVDPVidMem) >> VRAM_BLOCK_SHIFT]);
+            NEWER(vramRegionGen[(ColTab - pVDPVidMem) >> VRAM_REGION_SHIFT]);
+            break;
+        case 2: // Graphics II - the third of the pattern and colour tables (subject to the table masks)
+            NEWER(vramRegionGen[((ChrTab - pVDPVidMem) + ((Y&0xF8)<<2)) >> VRAM_REGION_SHIFT]);
+            NEWER(vramBlockGen[((ChrGen - pVDPVidMem) + (((Y&0xC0)<<5) & ChrGenM)) >> VRAM_BLOCK_SHIFT]);
+            NEWER(vramBlockGen[((ColTab - pVDPVidMem) + (((Y&0xC0)<<5) & ColTabM)) >> VRAM_BLOCK_SHIFT]);
+            break;
+        default: // Multicolor
+            NEWER(vramRegionGen[((ChrTab - pVDPVidMem) + ((Y&0xF8)<<2)) >> VRAM_REGION_SHIFT]);
+            NEWER(vramBlockGen[(ChrGen - pVDPVidMem) >> VRAM_BLOCK_SHIFT]);
+            break;
+    }
+
+    if (sprites) NEWER(vramBlockGen[(SprGen - pVDPVidMem) >> VRAM_BLOCK_SHIFT]);
+
+    return gen;
+    #undef NEWER
+}
+
+// ----------------------------------------------------------------------------------------
+// Draw line Y into XBuf - but only if something it is drawn from has changed since it
+// was last drawn into this buffer. Most frames only change a few rows of the name table
+// and a handful of sprites so most lines are left exactly as they are. The sprites are
+// compared by their attribute bytes as a sprite moving onto or off of a line doesn't
+// touch anything else the line is drawn from. The sprite scan is always done as that
+// keeps the 5th sprite status up to date.
+// ----------------------------------------------------------------------------------------
+static inline __attribute__((always_inline)) void RenderLine(u8 Y)
+{
+    unsigned int M;
+    int N = ScanSprites(Y, &M);
+
+    tLineSig *sig = &lineSig[XBuf != XBuf_A][Y];
+    u32 *attr = (u32*)SprTab;
+    u8 same = (sig->gen >= LineSourceGen(Y, M)) && (sig->sprMask == M);
+
+    u8 count = 0;
+    for (u32 m = M; m && same; m &= (m-1))
+    {
+        if (count == LINE_SPRITES) same = 0;
+        else if (sig->sprAttr[count++] != attr[__builtin_ctz(m)]) same = 0;
+    }
+
+    if (same)
+    {
+        RefreshSprites(Y, N, M, 0);     // Still need to look for sprite collisions
+        return;
+    }
+
+    RefreshLine(Y);
+    RefreshSprites(Y, N, M, 1);
+
+    sig->gen = vdpGen;
+    sig->sprMask = M;
+    count = 0;
+    for (u32 m = M; m; m &= (m-1))
+    {
+        if (count == LINE_SPRITES) {sig->gen = 0; break;}  // Too many sprites to remember - always redraw this line
+        sig->sprAttr[count++] = attr[__builtin_ctz(m)];
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+// Do we need to render this line? A lot of TI games leave the screen alone for long
+// stretches (title screens, menus, text adventures) so a frame is only drawn when
+// something that feeds the picture has changed. A change part way down the frame turns
+// rendering on from that line - the lines above were drawn from the same VRAM last time.
+// The next full frame is drawn too... or the next three with frame blending as both of
+// the ping-pong buffers must catch up and the blend is only output every other frame.
+// ----------------------------------------------------------------------------------------
+static inline __attribute__((always_inline)) u8 LineNeedsRender(void)
+{
+    if (vdpDirty)
+    {
+        vdpDirty  = 0;
+        vdpRender = 1;
+        vdpRedraw = (myConfig.frameBlend ? 3:1);
+    }
+
+    if (CurLine == tms_start_line)
+    {
+        vdpRender = (vdpRedraw != 0);
+        if (vdpRedraw) vdpRedraw--;
+    }
+
+    return vdpRender;
+}
+
 ITCM_CODE byte Loop9918(void)
 {
   extern void TI99UpdateScreen(void);
@@ -799,51 +1045,36 @@ ITCM_CODE byte Loop9918(void)
   /* If refreshing display area, call scanline handler */
   if ((CurLine >= tms_start_line) && (CurLine < tms_end_line))
   {
-      if ((frameSkipIdx & frameSkip[myConfig.frameSkip]) == 0)
+      if (((frameSkipIdx & frameSkip[myConfig.frameSkip]) == 0) || !LineNeedsRender())
       {
           unsigned int tmp;
-          ScanSprites(CurLine - tms_start_line, &tmp);    // Skip rendering - but still scan sprites for 5th sprite flag
+          int last = ScanSprites(CurLine - tms_start_line, &tmp);   // Skip rendering (frameskip or nothing changed) - but still scan sprites for 5th sprite flag
+          RefreshSprites(CurLine - tms_start_line, last, tmp, 0);   // And check for sprite collisions on this line
       }
       else
       {
-          RefreshLine(CurLine - tms_start_line);
-      }
-
-      // ---------------------------------------------------------------------------
-      // Some programs require that we handle collisions more frequently than just
-      // end of line. So we check every X scanlines. This is somewhat CPU intensive
-      // so we are careful how often we run it - especially on older hardware.
-      // ---------------------------------------------------------------------------
-      if ((CurLine % scan_collisions_every) == 0)
-      {
-          if (!(VDPStatus&TMS9918_STAT_OVRLAP)) // If not already in collision...
-          {
-             if (CheckSprites()) VDPStatus|=TMS9918_STAT_OVRLAP; // Set the collision bit
-          }
+          RenderLine(CurLine - tms_start_line);
       }
   }
   /* If time for emulated VBlank... */
   else if (CurLine == tms_end_line)
   {
-      /* Refresh screen */
-      if ((frameSkipIdx & frameSkip[myConfig.frameSkip]) != 0)
+      /* Refresh screen - unless it's identical to what is already showing */
+      if (((frameSkipIdx & frameSkip[myConfig.frameSkip]) != 0) && vdpRender)
       {
           TI99UpdateScreen();
       }
 
       frameSkipIdx++;
 
+      /* Restart the VRAM write generations long before they can wrap */
+      if (vdpGen >= VDP_GEN_LIMIT) VDP_GenReset();
+
       /* Generate IRQ when enabled and when VBlank flag goes up */
       bIRQ=TMS9918_VBlankON && !(VDPStatus&TMS9918_STAT_VBLANK);
 
       /* Set VBlank status flag */
       VDPStatus|=TMS9918_STAT_VBLANK;
-
-      /* At the end of a frame, we always do one more collision check */
-      if (!(VDPStatus&TMS9918_STAT_OVRLAP)) // If not already in collision...
-      {
-        if (CheckSprites()) VDPStatus|=TMS9918_STAT_OVRLAP; // Set the collision bit
-      }
   }
 
   /* Done */
@@ -876,6 +1107,8 @@ void Reset9918(void)
     ChrTab=ColTab=ChrGen=pVDPVidMem;    // VDP tables (screen)
     SprTab=SprGen=pVDPVidMem;           // VDP tables (sprites)
     VDPDlatch = 0;                      // VDP Data latch
+    VDP_GenReset();                     // Nothing on screen is from this VDP yet
+    vdpRedraw = 0;                      // So the next frame is drawn in full
 
     ChrGenM = 0x3FFF;                   // Full mask by default
     ColTabM = 0x3FFF;                   // Full mask by default
@@ -893,16 +1126,15 @@ void Reset9918(void)
     tms_cpu_line   = (myConfig.isPAL ? TMS9929_LINE        :  TMS9918_LINE);
 
     // -----------------------------------------------------------------------
-    // Determine how often we should check for sprite collisions. Some clever
-    // demos and games require that we check more often than end of frame.
+    // Zoomed sprites cover two pixels for each bit - used for collisions.
     // -----------------------------------------------------------------------
-    if (myConfig.spriteCheck) // Force a specific collision check value?
-    {
-        scan_collisions_every = CollisionCheckEvery[myConfig.spriteCheck];
-    }
-    else // Use "normal" default values
+    for (int i=0; i<256; i++)
     {
-        scan_collisions_every = (isDSiMode() ? 32 : 64);  // Reasonable values for DSi vs DS-Lite/Phat on how often to check for collisions
+        spriteDouble[i] = 0;
+        for (int bit=0; bit<8; bit++)
+        {
+            if (i & (1<<bit)) spriteDouble[i] |= (3 << (bit*2));
+        }
     }
 
     // ---------------------------------------------------------------
@@ -913,8 +1145,6 @@ void Reset9918(void)
     {
         for (colbg=0;colbg<16;colbg++)
         {
-          fastBackgroundLut[(colfg<<4) | colbg] = (colbg<<0) | (colbg<<8) | (colbg<<16) | (colbg<<24); // 0 0 0 0 - this one is called often enough that we keep it in fast DTCM memory
-
           lutTablehh[(colfg<<4) | colbg][ 0] = (colbg<<0) | (colbg<<8) | (colbg<<16) | (colbg<<24); // 0 0 0 0
           lutTablehh[(colfg<<4) | colbg][ 1] = (colbg<<0) | (colbg<<8) | (colbg<<16) | (colfg<<24); // 0 0 0 1
           lutTablehh[(colfg<<4) | colbg][ 2] = (colbg<<0) | (colbg<<8) | (colfg<<16) | (colbg<<24); // 0 0 1 0
@@ -78,6 +78,25 @@ extern u8 pVDPVidMem[];
 extern u8 VDPDlatch;
 extern u16 VAddr;
 extern u8 VDPCtrlLatch;
+extern u8 vdpDirty;
+
+// -------------------------------------------------------------------------------------
+// VRAM write tracking - every change to VRAM stamps the 32 byte region (one name table
+// row) and the 2K block it falls in with a new generation. The renderer remembers the
+// generation each line was drawn at so it can tell if anything feeding it has changed.
+// -------------------------------------------------------------------------------------
+#define VRAM_REGION_SHIFT   5
+#define VRAM_BLOCK_SHIFT    11
+#define VDP_GEN_LIMIT       0xF0000000      // Generations are restarted at the next VBlank once vdpGen gets this far
+
+extern u32 vdpGen;
+extern u32 vdpRegGen;
+extern u32 vramRegionGen[0x4000 >> VRAM_REGION_SHIFT];
+extern u32 vramBlockGen[0x4000 >> VRAM_BLOCK_SHIFT];
+
+extern void VRAM_Changed(u16 addr, u16 len);
+extern void VDP_Invalidate(void);
+extern void VDP_GenReset(void);
 
 extern void WrCtrl9918(byte value);
 
@@ -86,6 +105,11 @@ extern void WrCtrl9918(byte value);
 /*************************************************************/
 inline void WrData9918(byte V)  // This one is used frequently so we try to inline it
 {
+    if (pVDPVidMem[VAddr] != V)     // Only a real change means the screen must be redrawn
+    {
+        vramRegionGen[VAddr >> VRAM_REGION_SHIFT] = vramBlockGen[VAddr >> VRAM_BLOCK_SHIFT] = ++vdpGen;
+        vdpDirty = 1;
+    }
     VDPDlatch = pVDPVidMem[VAddr] = V;
     VAddr     = (VAddr+1)&0x3FFF;
     VDPCtrlLatch = 0;
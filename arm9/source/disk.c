@@ -59,6 +59,7 @@
 #include "cpu/tms9900/tms9900.h"
 #include "cpu/tms9918a/tms9918a.h"
 #include "disk.h"
+#include "scheduler.h"
 
 u8 TICC_REG[8] = {0,0,0,0,0,0,0,0};
 u8 TICC_DIR=0;   // 0 means towards track 0
@@ -102,6 +103,15 @@ void disk_init(void)
     diskSideSelected      = 0;
     driveSelected         = DSK1;
     motorOn               = 0;
+    Scheduler_Cancel(EVT_DISK_MOTOR);
+}
+
+// ------------------------------------------------------
+// The motor strobe has run out without being re-strobed
+// ------------------------------------------------------
+void disk_motor_timeout(void)
+{
+    motorOn = 0;
 }
 
 // ------------------------------------------------------
@@ -147,9 +157,11 @@ void disk_cru_write(u16 address, u8 data)
                 memset(&MemCPU[0x4000], 0xFF, 0x2000);
                 MemType[0x5ff0>>4] = MF_PERIF;     // Disk Control registers NOT visible
             }
+            TMS9900_MapPages(0x4000, 0x2000);   // The whole DSR space has been replaced
             break;
         case 1:
-            motorOn = data;  // If enabled, strobe motor for 4.23 seconds... we just track motor on/off
+            motorOn = data;  // If enabled, strobe motor for 4.23 seconds...
+            if (data) Scheduler_Add(EVT_DISK_MOTOR, tms9900.cycles + DISK_MOTOR_CYCLES);
             break;
         case 4:     // select drive 1
         case 5:     // select drive 2
@@ -357,6 +369,7 @@ void WriteTICCRegister(u16 address, u8 val)
                 {
                     memcpy(&pVDPVidMem[destVDP], &Disk[drive].image[index], 256);
                 }
+                VRAM_Changed(destVDP, 256);                  // The sector may have landed somewhere on screen
                 *((u16*)&MemCPU[0x834A]) = sectorNumber;     // fill in the return data
                 Disk[drive].driveReadCounter = 2;            // briefly show that we are reading from the disk
                 MemCPU[0x8350] = 0;                          // should still be 0 if no error occurred
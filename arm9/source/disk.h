@@ -5,6 +5,7 @@
 
 #define MAX_DSK_SIZE        (360*1024)  // 360K maximum .dsk size
 #define MAX_DSK_SECTORS     1440        // For all disks we support 1440x256=360K
+#define DISK_MOTOR_CYCLES   (4230*3000) // The motor strobe lasts 4.23 seconds of 3MHz CPU clocks
 
 // Three disks supported.. that should be fine for just about anything
 enum
@@ -54,6 +55,7 @@ extern void WriteTICCRegister(u16 address, u8 val);
 extern void HandleTICCSector(void);
 extern void disk_cru_write(u16 address, u8 data);
 extern u8   disk_cru_read(u16 address);
+extern void disk_motor_timeout(void);
 extern void disk_mount(u8 drive, char *path, char *filename);
 extern void disk_unmount(u8 drive);
 extern void disk_read_from_sd(u8 drive);
@@ -60,6 +60,25 @@ u8 pcode_cru_read(u16 address)
     return 0;
 }
 
+// ---------------------------------------------------------------------------------------------
+// Map the current 4K p-code DSR bank in at >5000. This is done through the memory page table
+// so a bank flip is just a pointer swap. The two pages that also hold the p-code GROM registers
+// (>5BFC and >5FFC) go through the slow memory handlers which read from MemCPU[] so those two
+// pages get copied - 512 bytes rather than the whole 4K.
+// ---------------------------------------------------------------------------------------------
+static void pcode_map_bank(void)
+{
+    u8 *bank = MemCART + (0x1000 + (0x1000 * pcode_bank));
+
+    memcpy(&MemCPU[0x5B00], bank + 0x0B00, 0x100);
+    memcpy(&MemCPU[0x5F00], bank + 0x0F00, 0x100);
+
+    for (u16 page = 0x50; page < 0x60; page++)
+    {
+        if (MemPageRead[page]) MemPageRead[page] = bank + ((page & 0x0F) << 8);
+    }
+}
+
 // ---------------------------------------------------------------
 // The p-code system responds mainly to two CRU bits...
 //
@@ -84,6 +103,8 @@ void pcode_cru_write(u16 address, u8 data)
             MemType[0x5BFC>>4] = MF_PCODE;
             MemType[0x5FFC>>4] = MF_PCODE;
             pcode_visible = 1;
+            TMS9900_MapPages(0x4000, 0x2000);
+            pcode_map_bank();
         }
         else
         {
@@ -92,15 +113,15 @@ void pcode_cru_write(u16 address, u8 data)
             MemType[0x5BFC>>4] = MF_PERIF;
             MemType[0x5FFC>>4] = MF_PERIF;
             pcode_visible = 0;
+            TMS9900_MapPages(0x4000, 0x2000);
         }
-        
     }
     else if (address == 0x40) // Is this the DSR banking bit? (which responds to >1F80 due to p-code card logic... by the time it gets here it's weight >40)
     {
         pcode_bank = (data & 1);
         if (pcode_visible)
         {
-            memcpy(&MemCPU[0x5000], MemCART + (0x1000 + (0x1000 * pcode_bank)), 0x1000);    // Make sure the right 4K bank is in place
+            pcode_map_bank();   // Make sure the right 4K bank is in place
         }
     }
 }
@@ -64,6 +64,7 @@
 #include <stddef.h>  /* ptrdiff_t */
 #include <ctype.h>   /* toupper() */
 #include "lowzip.h"
+#include "../CRC32.h"
 
 /*
  *  ZIP defines (see ZIP APPNOTE)
@@ -86,6 +87,19 @@
 /* Scratch area offset for distance Huffman tree. */
 #define LOWZIP_SCRATCH_HUFF_DIST  604
 
+/* Codes up to this many bits are decoded with a single table lookup; longer
+ * (rare) codes fall back to the canonical bit-at-a-time decoder.  Each entry
+ * is (code length << 9) + terminal value, or 0 for "longer than this".
+ */
+#define LOWZIP_FAST_BITS          9
+#define LOWZIP_FAST_MASK          ((1U << LOWZIP_FAST_BITS) - 1U)
+
+/* Fast lookup tables for the current dynamic block.  2kB in total which is
+ * too much to keep in the state structure (the caller keeps that in DTCM).
+ */
+static unsigned short lowzip_fast_lit[1U << LOWZIP_FAST_BITS];
+static unsigned short lowzip_fast_dist[1U << LOWZIP_FAST_BITS];
+
 /* Extra bits for 'length', from RFC 1951 Section 3.2.5.  Index is code - 257,
  * value is extra bits to read for the length value.
  */
@@ -186,9 +200,27 @@ static unsigned int lowzip_read1(lowzip_state *st, unsigned int offset) {
  * However, an error return value would need to be checked by a lot of call
  * sites, and a longjmp (or similar) is a portability concern.
  */
+static unsigned int lowzip_fill(lowzip_state *st) {
+	unsigned int got;
+
+	got = st->fill_callback(st->udata, st->read_offset, &st->in_next);
+	st->in_end = st->in_next + got;
+	return got;
+}
+
 static unsigned int lowzip_read_byte(lowzip_state *st) {
 	unsigned int x;
 
+	/* Bulk input: almost every read is just a pointer bump. */
+	if (st->in_next < st->in_end || (st->fill_callback && lowzip_fill(st))) {
+		st->read_offset++;
+		return *st->in_next++;
+	}
+	if (st->fill_callback) {
+		st->have_error = 1;
+		return 0;
+	}
+
 	x = st->read_callback(st->udata, st->read_offset);
 	if (!(x & 0x100U)) {
 		st->read_offset++;
@@ -268,12 +300,32 @@ static unsigned int lowzip_read_bits_reversed(lowzip_state *st, unsigned int nbi
 #endif
 
 static void lowzip_reset_bitstate(lowzip_state *st) {
-#if 0
-	st->curr = 0;  /* Not necessary because of masking. */
-#endif
+	st->curr = 0;  /* Needed: the fast Huffman path looks at bits above 'have'. */
 	st->have = 0;
 }
 
+/* Make sure at least 'nbits' bits are buffered for a table lookup.  Unlike
+ * lowzip_read_bits() running out of input is not an error here: the final
+ * code of a stream may be shorter than the lookup width.  Padding is zero
+ * and any real overrun is caught by the length and CRC checks at the end.
+ */
+static void lowzip_need_bits(lowzip_state *st, unsigned int nbits) {
+	unsigned int x;
+
+	while (st->have < nbits) {
+		if (st->in_next < st->in_end || (st->fill_callback && lowzip_fill(st))) {
+			x = *st->in_next++;
+			st->read_offset++;
+		} else if (!st->fill_callback && !((x = st->read_callback(st->udata, st->read_offset)) & 0x100U)) {
+			st->read_offset++;
+		} else {
+			x = 0;
+		}
+		st->curr |= x << st->have;
+		st->have += 8;
+	}
+}
+
 /*
  *  Huffman decoding
  */
@@ -383,6 +435,41 @@ static void lowzip_prepare_huffman(lowzip_state *st,
 	st->have_error = 1;
 }
 
+/* Build the fast lookup table for a prepared Huffman table.  Canonical codes
+ * are assigned in (length, terminal) order and are sent most significant bit
+ * first, so each code is bit reversed to index the table and replicated for
+ * every value of the unused upper bits.
+ */
+static void lowzip_prepare_fast(unsigned short *huff, unsigned short *fast) {
+	unsigned short *counts_ptr;
+	unsigned short *codes_ptr;
+	unsigned int code;
+	unsigned int len;
+	unsigned int n;
+	unsigned int i;
+	unsigned int rev;
+
+	counts_ptr = huff;
+	codes_ptr = huff + 16;
+	memset((void *) fast, 0, sizeof(unsigned short) << LOWZIP_FAST_BITS);
+
+	code = 0;
+	for (len = 1; len <= LOWZIP_FAST_BITS; len++) {
+		for (n = counts_ptr[len]; n > 0; n--) {
+			rev = 0;
+			for (i = 0; i < len; i++) {
+				rev |= ((code >> i) & 1U) << (len - 1U - i);
+			}
+			for (i = rev & LOWZIP_FAST_MASK; i <= LOWZIP_FAST_MASK; i += (1U << len)) {
+				fast[i] = (unsigned short) ((len << 9U) + *codes_ptr);
+			}
+			codes_ptr++;
+			code++;
+		}
+		code <<= 1U;
+	}
+}
+
 /* Huffman decode a terminal value from the input. */
 static unsigned int lowzip_decode_huffman(lowzip_state *st, unsigned short *huff) {
 	unsigned int code;
@@ -441,6 +528,22 @@ static unsigned int lowzip_decode_huffman(lowzip_state *st, unsigned short *huff
 	return 0;
 }
 
+/* Huffman decode using the fast lookup table, falling back to the bit at a
+ * time decoder for codes longer than LOWZIP_FAST_BITS.
+ */
+static inline unsigned int lowzip_decode_huffman_fast(lowzip_state *st, unsigned short *huff, unsigned short *fast) {
+	unsigned int e;
+
+	lowzip_need_bits(st, LOWZIP_FAST_BITS);
+	e = fast[st->curr & LOWZIP_FAST_MASK];
+	if (e) {
+		st->curr >>= (e >> 9U);
+		st->have -= (e >> 9U);
+		return e & 0x1ffU;
+	}
+	return lowzip_decode_huffman(st, huff);
+}
+
 /*
  *  Inflate block decoding
  */
@@ -449,21 +552,49 @@ static unsigned int lowzip_decode_huffman(lowzip_state *st, unsigned short *huff
 static void lowzip_decode_uncompressed_block(lowzip_state *st) {
 	unsigned int len;
 
-	/* Discard unused partially read bits. */
-	lowzip_reset_bitstate(st);
+	/* Discard unused partially read bits.  The fast Huffman path may
+	 * have buffered whole bytes beyond them, so those are read through
+	 * the bit buffer before going back to the byte stream.
+	 */
+	lowzip_read_bits(st, st->have & 7U);
 
 	/* Parse block length.  Ignore one's complement of length which
 	 * is for error checking.  Checking it would be OK but somewhat
 	 * pointless because no other part of the deflate stream has any
 	 * redundancy checks.
 	 */
-	len = lowzip_read_byte(st);
-	len += lowzip_read_byte(st) << 8U;
-	lowzip_read_byte(st);  /* Skip NLEN. */
-	lowzip_read_byte(st);
+	len = lowzip_read_bits(st, 16);
+	lowzip_read_bits(st, 16);  /* Skip NLEN. */
+
+	while (len > 0 && st->have >= 8) {
+		lowzip_write_byte(st, lowzip_read_bits(st, 8));
+		len--;
+	}
+	lowzip_reset_bitstate(st);
+
+	/* Copy bytes to output verbatim - a window at a time if we can. */
+	while (len > 0 && st->fill_callback && !st->have_error) {
+		unsigned int n;
 
-	/* Copy bytes to output verbatim. */
-	while (len-- > 0) {
+		if (st->in_next >= st->in_end && !lowzip_fill(st)) {
+			st->have_error = 1;
+			break;
+		}
+		n = (unsigned int) (st->in_end - st->in_next);
+		if (n > len) {
+			n = len;
+		}
+		if ((ptrdiff_t) n > (ptrdiff_t) (st->output_end - st->output_next)) {
+			st->have_error = 1;
+			break;
+		}
+		memcpy(st->output_next, st->in_next, n);
+		st->output_next += n;
+		st->in_next += n;
+		st->read_offset += n;
+		len -= n;
+	}
+	while (len-- > 0 && !st->have_error) {
 		lowzip_write_byte(st, lowzip_read_byte(st));
 	}
 }
@@ -485,7 +616,7 @@ static void lowzip_decode_huffman_block_data(lowzip_state *st, int static_huffma
 
 		if (!static_huffman) {
 			/* Dynamic Huffman. */
-			t = lowzip_decode_huffman(st, (unsigned short *) ((unsigned char *) st->scratch + LOWZIP_SCRATCH_HUFF_LIT));
+			t = lowzip_decode_huffman_fast(st, (unsigned short *) ((unsigned char *) st->scratch + LOWZIP_SCRATCH_HUFF_LIT), lowzip_fast_lit);
 		} else {
 			/* Static Huffman, hand-crafted decoder. */
 			t = lowzip_read_bits_reversed(st, 7);  /* Minimum code length is 7. */
@@ -501,7 +632,11 @@ static void lowzip_decode_huffman_block_data(lowzip_state *st, int static_huffma
 		}
 
 		if (t < 256) {
-			lowzip_write_byte(st, (unsigned char) t);
+			if (st->output_next < st->output_end) {
+				*st->output_next++ = (unsigned char) t;
+			} else {
+				goto buffer_error;
+			}
 		} else if (t == 256) {
 			break;
 		} else {
@@ -517,7 +652,7 @@ static void lowzip_decode_huffman_block_data(lowzip_state *st, int static_huffma
 
 			if (!static_huffman) {
 				/* Dynamic Huffman. */
-				t = lowzip_decode_huffman(st, (unsigned short *) ((unsigned char *) st->scratch + LOWZIP_SCRATCH_HUFF_DIST));
+				t = lowzip_decode_huffman_fast(st, (unsigned short *) ((unsigned char *) st->scratch + LOWZIP_SCRATCH_HUFF_DIST), lowzip_fast_dist);
 			} else {
 				/* Static Huffman, hand-crafted decoder. */
 				t = lowzip_read_bits_reversed(st, 5);  /* Fixed 5-bit code, use as is. */
@@ -701,6 +836,9 @@ static void lowzip_decode_dynamic_huffman_block(lowzip_state *st) {
 		return;
 	}
 
+	lowzip_prepare_fast((unsigned short *) ((unsigned char *) st->scratch + LOWZIP_SCRATCH_HUFF_LIT), lowzip_fast_lit);
+	lowzip_prepare_fast((unsigned short *) ((unsigned char *) st->scratch + LOWZIP_SCRATCH_HUFF_DIST), lowzip_fast_dist);
+
 	/* Finally, decode the block contents. */
 
 	lowzip_decode_huffman_block_data(st, 0 /*static_huffman*/);
@@ -763,22 +901,11 @@ void lowzip_inflate_raw(lowzip_state *st) {
  *  ZIP CRC32
  */
 
+/* Same polynomial as the emulator's own file CRC so use its table driven
+ * (slice-by-8) version rather than a bit at a time loop.
+ */
 static unsigned int lowzip_zip_crc32(unsigned char *p_start, unsigned char *p_end) {
-	unsigned int crc = 0xffffffffUL;
-	int i;
-    
-	while (p_start < p_end) {
-		crc ^= (unsigned int) (*p_start++);
-		for (i = 0; i < 8; i++) {
-			if (crc & 0x01UL) {
-				crc = (crc >> 1U) ^ 0xedb88320UL;
-			} else {
-				crc = (crc >> 1U);
-			}
-		}
-	}
-
-	return crc ^ 0xffffffffUL;
+	return getCRC32(p_start, (unsigned int) (p_end - p_start));
 }
 
 /*
@@ -981,7 +1108,32 @@ void lowzip_get_data(lowzip_state *st) {
 	header_crc32 = fi->crc32;
 	header_uncompressed_size = fi->uncompressed_size;
 
-	if (fi->compression_method == LOWZIP_COMPRESSION_STORE) {
+	st->in_next = NULL;  /* Start with an empty input window. */
+	st->in_end = NULL;
+
+	if (fi->compression_method == LOWZIP_COMPRESSION_STORE && st->fill_callback) {
+		st->read_offset = fi->data_offset;
+		lowzip_reset_bitstate(st);
+		t = fi->uncompressed_size;
+		while (t > 0 && !st->have_error) {
+			unsigned int n;
+
+			if (!lowzip_fill(st)) {
+				goto fail;
+			}
+			n = (unsigned int) (st->in_end - st->in_next);
+			if (n > t) {
+				n = t;
+			}
+			if ((ptrdiff_t) n > (ptrdiff_t) (st->output_end - st->output_next)) {
+				goto fail;
+			}
+			memcpy(st->output_next, st->in_next, n);
+			st->output_next += n;
+			st->read_offset += n;
+			t -= n;
+		}
+	} else if (fi->compression_method == LOWZIP_COMPRESSION_STORE) {
 		offset = fi->data_offset;
 		offset_end = fi->data_offset + fi->uncompressed_size;
 		for (; offset < offset_end; offset++) {
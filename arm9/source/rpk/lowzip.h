@@ -7,6 +7,13 @@
  */
 typedef unsigned int (*lowzip_read_callback)(void *udata, unsigned int offset);
 
+/* Optional bulk read callback used for streaming through file data.  Points
+ * '*window' at the input starting at 'offset' and returns how many bytes are
+ * available there (0 if out of bounds or any other error).  The window must
+ * stay valid until the next call.
+ */
+typedef unsigned int (*lowzip_fill_callback)(void *udata, unsigned int offset, const unsigned char **window);
+
 /* Lowzip state structure, allocated and initialized (partially) by caller.
  * Also contains the inflate state.
  */
@@ -17,6 +24,9 @@ typedef struct {
 	/* User-provided read callback to access the ZIP file. */
 	lowzip_read_callback read_callback;
 
+	/* User-provided bulk read callback (may be NULL). */
+	lowzip_fill_callback fill_callback;
+
 	/* ZIP file length. */
 	unsigned int zip_length;
 
@@ -34,6 +44,12 @@ typedef struct {
 	/* Read offset (used by inflate code). */
 	unsigned int read_offset;
 
+	/* Current bulk input window, [in_next,in_end[ holds the bytes at
+	 * read_offset onwards (used by inflate code with fill_callback).
+	 */
+	const unsigned char *in_next;
+	const unsigned char *in_end;
+
 	/* State for bitstream decoding (used by inflate code). */
 	unsigned int curr;
 	unsigned int have;
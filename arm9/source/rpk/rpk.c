@@ -13,6 +13,8 @@
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#include <dirent.h>
+#include <unistd.h>
 #include "rpk.h"
 #include "lowzip.h"
 #include "yxml.h"
@@ -24,7 +26,7 @@
 typedef struct {
 	FILE *input;
 	unsigned int  input_length;
-	unsigned char input_chunk[0x400];   // 1024 byte buffer
+	unsigned char input_chunk[0x4000];  // 16K buffer - big enough that SD reads run at full speed
 	unsigned int  input_chunk_start;
 	unsigned int  input_chunk_end;
 } read_state;
@@ -35,11 +37,39 @@ yxml_t xml              __attribute__((section(".dtcm")));
 char xml_value[64]      __attribute__((section(".dtcm")));
 Layout_t cart_layout    __attribute__((section(".dtcm")));
 
+// -----------------------------------------------------------------------------------
+// Once an RPK has been unpacked we keep the result in a cache file (one per archive,
+// named by the archive CRC) so the next launch is a single sequential read with no
+// inflate and no XML parse. The cache holds the final memory image - the >6000 CPU
+// bank, the 40K of cart GROM and however much of the cart buffer the loader filled.
+// -----------------------------------------------------------------------------------
+#define RPK_CACHE_DIR       "/data/rpkcache"
+#define RPK_CACHE_MAGIC     0x434B5052      // 'RPKC'
+#define RPK_CACHE_VERSION   2               // 2: cart_type records the type the PCB forced even when it matched the config
+
+typedef struct
+{
+    u32      magic;
+    u16      version;
+    u16      bankMask;                      // Banking as the loader set it up
+    u32      archive_crc;                   // The cache is only good for this exact archive...
+    u32      archive_size;                  // ...of this exact size
+    u32      cart_bytes;                    // How much of MemCART follows the CPU and GROM images
+    u8       cart_type;                     // Cart type forced by the PCB (0xFF if the loader left the config alone)
+    u8       reserved[3];
+    Layout_t layout;                        // The parsed layout.xml (PCB type, listname, etc)
+} RPK_CacheHeader_t;
+
+static u32 rpk_cart_used = 0;               // High water mark of the cart buffer written by this load
+static u8  rpk_cart_type = 0xFF;            // Cart type the PCB forced on this load (0xFF if the loader left the config alone)
+
 // -----------------------------------------------------------------------
 // We pass this into the lowzip handler who will call us back to read  a
-// single byte from the file. Most of the time this will return quickly
-// as the byte will be in cached memory - but if not, it will read in a
-// single cached chunk (see input_chunk[] above) to minimize file I/O.
+// single byte from the file. This is only used for random access to the
+// ZIP directory - the file data itself goes through rpk_fill_file. Most
+// of the time this will return quickly as the byte will be in cached
+// memory - but if not, it will read in a single cached chunk (see
+// input_chunk[] above) to minimize file I/O.
 // -----------------------------------------------------------------------
 unsigned int rpk_read_file(void *udata, unsigned int offset)
 {
@@ -81,11 +111,35 @@ unsigned int rpk_read_file(void *udata, unsigned int offset)
 	return 0x100;
 }
 
+// -----------------------------------------------------------------------
+// The bulk version of the above for streaming through compressed data.
+// We hand lowzip a pointer into our chunk buffer and how many bytes are
+// there so it can run through a whole chunk without calling back. Reads
+// are sequential here so a new chunk starts right at the wanted offset.
+// -----------------------------------------------------------------------
+unsigned int rpk_fill_file(void *udata, unsigned int offset, const unsigned char **window)
+{
+	read_state *st = (read_state *) udata;
+
+	if (offset < st->input_chunk_start || offset >= st->input_chunk_end)
+	{
+		if (offset >= st->input_length) return 0;
+		if (fseek(st->input, (size_t) offset, SEEK_SET) != 0) return 0;
+		st->input_chunk_start = offset;
+		st->input_chunk_end = offset + fread((void *) st->input_chunk, 1, sizeof(st->input_chunk), st->input);
+		if (offset >= st->input_chunk_end) return 0;
+	}
+
+	*window = &st->input_chunk[offset - st->input_chunk_start];
+	return st->input_chunk_end - offset;
+}
+
 // ------------------------------------------------------------------------------------------------
 // This will call into lowzip to extract the file directly into our memory area - we don't even
 // bother buffering - if the load fails, we'll simply put 0xFF into memory to prevent the TI system
 // from seeing anything that resembles a program. lowzip is great - minimal size and very few
-// resources consumed ... but it is not the fastest. A 512K load takes a few seconds. Good enough!
+// resources consumed. It was never the fastest (a 512K load used to take a few seconds) but with
+// bulk input and table driven Huffman decoding it now keeps up with reading a raw .bin file.
 // This returns zero if everything went smoothly on unpacking the file. Non-zero otherwise.
 // ------------------------------------------------------------------------------------------------
 static u8 rpk_extract_located_file(lowzip_state *st, lowzip_file *fileinfo, u8 *buf, int max_size)
@@ -96,6 +150,11 @@ static u8 rpk_extract_located_file(lowzip_state *st, lowzip_file *fileinfo, u8 *
 
 	lowzip_get_data(st);
 
+	if ((buf >= MemCART) && (buf < MemCART + MAX_CART_SIZE) && ((u32)(st->output_next - MemCART) > rpk_cart_used))
+	{
+		rpk_cart_used = st->output_next - MemCART;
+	}
+
 	return (st->have_error) ? 1:0;
 }
 
@@ -130,9 +189,9 @@ u8 rpk_parse_xml(char *xml_str)
     memset(&cart_layout, 0x00, sizeof(cart_layout));
     u8 val_idx=0;
 
-    for (int i=0; i<strlen(xml_str); i++)
+    for (char *xml_ptr = xml_str; *xml_ptr; xml_ptr++)
     {
-        yxml_ret_t y = yxml_parse(&xml, (int)xml_str[i]);
+        yxml_ret_t y = yxml_parse(&xml, (int)*xml_ptr);
         switch (y)
         {
             case YXML_ELEMSTART:
@@ -443,7 +502,7 @@ u8 rpk_load_pagedcru(void)
                 if (rpk_extract_located_file(&st, fileinfo, MemCART, MAX_CART_SIZE) == 0)
                 {
                     memcpy(&MemCPU[0x6000], MemCART, 0x2000);   // This cart gets loaded directly into main memory
-                    myConfig.cartType = CART_TYPE_PAGEDCRU;
+                    myConfig.cartType = rpk_cart_type = CART_TYPE_PAGEDCRU;
                     
                     u16 numCartBanks = (fileinfo->uncompressed_size / 0x2000) + ((fileinfo->uncompressed_size % 0x2000) ? 1:0);
                     tms9900.bankMask = BankMasks[numCartBanks-1];   // Ensure we mask to the size of the uncompressed ROM
@@ -464,7 +523,7 @@ u8 rpk_load_mbx(void)
     u8 err = 0;
 
     err = rpk_load_standard();
-    myConfig.cartType = CART_TYPE_MBX_WITH_RAM;
+    myConfig.cartType = rpk_cart_type = CART_TYPE_MBX_WITH_RAM;
 
     return err;
 }
@@ -478,7 +537,7 @@ u8 rpk_load_minimem(void)
     u8 err = 0;
 
     err = rpk_load_standard();
-    myConfig.cartType = CART_TYPE_MINIMEM;
+    myConfig.cartType = rpk_cart_type = CART_TYPE_MINIMEM;
 
     return err;
 }
@@ -489,7 +548,7 @@ u8 rpk_load_super(void)
     u8 err = 0;
 
     err = rpk_load_standard();
-    myConfig.cartType = CART_TYPE_SUPERCART;
+    myConfig.cartType = rpk_cart_type = CART_TYPE_SUPERCART;
 
     return err;
 }
@@ -525,6 +584,7 @@ u8 rpk_load_paged7(void)
 
         memcpy(MemCPU+0x6000,  swapArea, 0x2000);           // Bank 0 + Bank 0
         memcpy(MemCART+0x0000, swapArea, 0x8000);           // The new 32K ROM with all the banks in place
+        if (rpk_cart_used < 0x8000) rpk_cart_used = 0x8000;
 
         tms9900.bankMask = 0x0003;                          // We have 4 banks.
     }
@@ -533,12 +593,95 @@ u8 rpk_load_paged7(void)
 }
 
 // ------------------------------------------------------------------------------
-// This is the only public interface - the caller should pass the filename.rpk
-// and this will unpack it and extract the layout.xml and figure out what
+// Try to load the unpacked image of this archive (file_crc/file_size are the
+// CRC and size of the .rpk itself) from the cache. Returns 1 if it was valid
+// and everything is now in place, 0 if the archive needs to be unpacked.
+// ------------------------------------------------------------------------------
+static u8 rpk_cache_read(void)
+{
+    static RPK_CacheHeader_t hdr;   // Over 1K with the layout - keep it off the (DTCM) stack
+    char path[48];
+
+    sprintf(path, "%s/%08X.dat", RPK_CACHE_DIR, (unsigned int)file_crc);
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) return 0;
+
+    u8 ok = (fread(&hdr, sizeof(hdr), 1, fp) == 1);
+    ok = ok && (hdr.magic == RPK_CACHE_MAGIC) && (hdr.version == RPK_CACHE_VERSION);
+    ok = ok && (hdr.archive_crc == file_crc) && (hdr.archive_size == file_size);
+    ok = ok && (hdr.cart_bytes <= MAX_CART_SIZE);
+
+    if (ok)
+    {
+        ok = (fread(&MemCPU[0x6000],  1, 0x2000, fp) == 0x2000) &&
+             (fread(&MemGROM[0x6000], 1, 0xA000, fp) == 0xA000) &&
+             (fread(MemCART, 1, hdr.cart_bytes, fp) == hdr.cart_bytes);
+
+        if (!ok)    // Truncated cache file - put things back the way the archive load expects to find them
+        {
+            memset(&MemCPU[0x6000],  0xFF, 0x2000);
+            memset(&MemGROM[0x6000], 0xFF, 0xA000);
+            memset(MemCART,          0xFF, hdr.cart_bytes);
+        }
+    }
+    fclose(fp);
+
+    if (ok)
+    {
+        memcpy(&cart_layout, &hdr.layout, sizeof(cart_layout));
+        tms9900.bankMask = hdr.bankMask;
+        if (hdr.cart_type != 0xFF) myConfig.cartType = hdr.cart_type;
+    }
+
+    return ok;
+}
+
+// ------------------------------------------------------------------------------
+// Write the image we just unpacked out to the cache. Any failure here just
+// means the next launch unpacks the archive again - so errors are ignored.
+// ------------------------------------------------------------------------------
+static void rpk_cache_write(void)
+{
+    static RPK_CacheHeader_t hdr;   // Over 1K with the layout - keep it off the (DTCM) stack
+    char path[48];
+
+    DIR* dir = opendir("/data");
+    if (dir) closedir(dir);     // directory exists.
+    else mkdir("/data", 0777);  // Doesn't exist - make it...
+
+    dir = opendir(RPK_CACHE_DIR);
+    if (dir) closedir(dir);
+    else mkdir(RPK_CACHE_DIR, 0777);
+
+    memset(&hdr, 0x00, sizeof(hdr));
+    hdr.magic        = RPK_CACHE_MAGIC;
+    hdr.version      = RPK_CACHE_VERSION;
+    hdr.bankMask     = tms9900.bankMask;
+    hdr.archive_crc  = file_crc;
+    hdr.archive_size = file_size;
+    hdr.cart_bytes   = rpk_cart_used;
+    hdr.cart_type    = rpk_cart_type;
+    memcpy(&hdr.layout, &cart_layout, sizeof(cart_layout));
+
+    sprintf(path, "%s/%08X.dat", RPK_CACHE_DIR, (unsigned int)file_crc);
+    FILE *fp = fopen(path, "wb");
+    if (fp)
+    {
+        u8 ok = (fwrite(&hdr, sizeof(hdr), 1, fp) == 1) &&
+                (fwrite(&MemCPU[0x6000],  1, 0x2000, fp) == 0x2000) &&
+                (fwrite(&MemGROM[0x6000], 1, 0xA000, fp) == 0xA000) &&
+                (fwrite(MemCART, 1, rpk_cart_used, fp) == rpk_cart_used);
+        fclose(fp);
+        if (!ok) remove(path);  // Don't leave a partial cache lying around (the SD card is probably full)
+    }
+}
+
+// ------------------------------------------------------------------------------
+// Unpack the archive itself - extract the layout.xml and figure out what
 // individual roms get loaded where in the memory map... It returns 0 if there
 // were no errors or non-zero if an error was encoutered.
 // ------------------------------------------------------------------------------
-u8 rpk_load(const char* filename)
+static u8 rpk_load_archive(const char* filename)
 {
     lowzip_file *fileinfo;
     FILE *input = NULL;
@@ -558,6 +701,7 @@ u8 rpk_load(const char* filename)
 
     st.udata = (void *) &read_st;
     st.read_callback = rpk_read_file;
+    st.fill_callback = rpk_fill_file;
     st.zip_length = read_st.input_length;
 
     // Initialize the lowzip library
@@ -619,6 +763,27 @@ u8 rpk_load(const char* filename)
 
     fclose(input);
 
+    return errors;
+}
+
+// ------------------------------------------------------------------------------
+// This is the only public interface - the caller should pass the filename.rpk
+// and this will either pull the unpacked image from the cache or unpack it and
+// work out what individual roms get loaded where in the memory map... It
+// returns 0 if there were no errors or non-zero if an error was encoutered.
+// ------------------------------------------------------------------------------
+u8 rpk_load(const char* filename)
+{
+    u8 errors = 0;
+
+    if (!rpk_cache_read())
+    {
+        rpk_cart_used = 0;
+        rpk_cart_type = 0xFF;
+        errors = rpk_load_archive(filename);
+        if (!errors) rpk_cache_write();
+    }
+
     if (errors)
     {
         memset(&MemCPU[0x6000],  0xFF, 0x2000);   // Failed to load - clear main memory CART area
@@ -632,8 +797,6 @@ u8 rpk_load(const char* filename)
         // -------------------------------------------------------------------------------------------
         if (strcasecmp(cart_layout.listname, "qbert")    == 0)  SetDiagonals();             // Q-Bert wants to play using diagnoal movement
         if (strcasecmp(cart_layout.listname, "frogger")  == 0)  MapPlayer2();               // Frogger uses the P2 controller port
-        if (strcasecmp(cart_layout.listname, "congobng") == 0)  myConfig.RAMMirrors = 1;    // TI-99/4a Congo Bongo requires RAM mirrors to run properly
-        if (strcasecmp(cart_layout.listname, "buckrog")  == 0)  myConfig.RAMMirrors = 1;    // TI-99/4a Buck Rogers requires RAM mirrors to run properly
     }
 
     return errors;
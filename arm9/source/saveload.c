@@ -26,7 +26,9 @@
 #include "DS99mngt.h"
 #include "DS99_utils.h"
 #include "SAMS.h"
+#include "cartstream.h"
 #include "disk.h"
+#include "scheduler.h"
 #include "pcode.h"
 #include "speech.h"
 
@@ -78,12 +80,17 @@ void TI99SaveState()
     uNbO = fwrite(&save_ver, sizeof(u16), 1, handle);
     
     // Write TMS9900 CPU and TMS9901 IO handling memory
+    TMS9900_SyncStatus();   // Make sure the status word is fully materialized (lazy flags)
+    Scheduler_SaveState();  // Bring the scanline overage and 9901 timer counter up to date from the event schedule
     if (uNbO) uNbO = fwrite(&tms9900, sizeof(tms9900), 1, handle);
     if (uNbO) uNbO = fwrite(&tms9901, sizeof(tms9901), 1, handle);
       
     // Write SAMS memory indexes
     if (uNbO) uNbO = fwrite(&theSAMS, sizeof(theSAMS),1, handle); 
       
+    // The Super Cart RAM bank is mapped straight from the cart buffer - put a copy where the save state has always kept the working bank
+    if (myConfig.cartType == CART_TYPE_SUPERCART) memcpy(MemCPU+0x6000, MemCART+SUPERCART_BANK_OFFSET(super_bank), 0x2000);
+
     // Save TI Memory that might possibly be volatile (RAM areas mostly)
     if (uNbO) uNbO = fwrite(MemCPU+0x6000, 0x2000, 1, handle);  // Could be 'Super Space' cart with RAM
     if (uNbO) uNbO = fwrite(MemCPU+0x8000, 0x0400, 1, handle);  // RAM with mirrors needs saving
@@ -266,6 +273,7 @@ void TI99LoadState()
         if (save_ver == TI_SAVE_VER)
         {
             // Load TMS9900 CPU and TMS9901 IO handling memory
+            TMS9900_SyncStatus();   // Retire any pending lazy flags - the saved status word replaces them
             if (uNbO) uNbO = fread(&tms9900, sizeof(tms9900), 1, handle);
             if (uNbO) uNbO = fread(&tms9901, sizeof(tms9901), 1, handle);
             
@@ -273,7 +281,8 @@ void TI99LoadState()
             if (uNbO) uNbO = fread(&theSAMS, sizeof(theSAMS),1, handle); 
             
             // Ensure we are pointing to the right cart bank in memory
-            tms9900.cartBankPtr = MemCART+tms9900.bankOffset;
+            if (cartStreaming) tms9900.cartBankPtr = CartStream_Bank(tms9900.bankOffset / 0x2000);
+            else tms9900.cartBankPtr = MemCART+tms9900.bankOffset;
             
             // Restore TI Memory that might possibly be volatile (RAM areas mostly)
             if (uNbO) uNbO = fread(MemCPU+0x6000, 0x2000, 1, handle); 
@@ -293,6 +302,10 @@ void TI99LoadState()
             // Restore the Memory Types for each region of memory
             if (uNbO) uNbO = fread(MemType, sizeof(MemType), 1, handle);     
             
+            // The memory map may have changed so rebuild the page table and start with an empty decoded instruction cache
+            TMS9900_MapPages(0x0000, 0x10000);
+            TMS9900_FlushDecodeCache();
+            
             // A few frame counters and other sundry bits of info
             if (uNbO) uNbO = fread(&emuActFrames, sizeof(emuActFrames), 1, handle); 
             if (uNbO) uNbO = fread(&timingFrames, sizeof(timingFrames), 1, handle); 
@@ -325,6 +338,7 @@ void TI99LoadState()
             SprGen = pSvg + pVDPVidMem;
             if (uNbO) uNbO = fread(&pSvg, sizeof(pSvg),1, handle); 
             SprTab = pSvg + pVDPVidMem;
+            VDP_Invalidate();   // Whatever is on screen is from before the restore
             
             // Load PSG Sound Stuff
             if (uNbO) uNbO = fread(&snti99, sizeof(snti99),1, handle);
@@ -340,6 +354,9 @@ void TI99LoadState()
             if (uNbO) uNbO = fread(&driveSelected, sizeof(driveSelected),1, handle); 
             if (uNbO) uNbO = fread(&motorOn, sizeof(motorOn),1, handle);
             
+            // Rebuild the event schedule from the CPU, timer and disk motor state we just loaded
+            Scheduler_RestoreState();
+
             // If the disk drive DSR was installed... put it back into the peripheral memory
             if (bDiskDeviceInstalled)
             {
@@ -363,6 +380,7 @@ void TI99LoadState()
             if (uNbO) uNbO = fread(&spare, 512,1, handle); 
             
             // SAMS memory is huge (1MB) so we will do some simple Run-Length Encoding of 0x00000000 dwords 
+            SAMS_ClearMemory();     // Start from all zeros - only banks with something in them get a page back
             u32 i=0;
             u32 zero=0x00000000;
             while (i < (theSAMS.numBanks * (4*1024)))
@@ -391,6 +409,10 @@ void TI99LoadState()
                 if (uNbO) uNbO = fread(&super_bank,  sizeof(super_bank),  1, handle); 
                 if (uNbO) uNbO = fread(&cart_cru_shadow,  sizeof(cart_cru_shadow),  1, handle); 
                 if (uNbO) uNbO = fread(&MemCART[MAX_CART_SIZE-0x8000], 0x8000, 1, handle); 
+
+                // The working bank was saved at >6000 - put it back into its slot and map it in
+                memcpy(MemCART+SUPERCART_BANK_OFFSET(super_bank), MemCPU+0x6000, 0x2000);
+                WriteBankSuperCart(super_bank);
             }
             
             if (myConfig.cartType == CART_TYPE_PAGEDCRU)
@@ -0,0 +1,129 @@
+// =====================================================================================
+// Copyright (c) 2023-2026 Dave Bernazzani (wavemotion-dave)
+//
+// Copying and distribution of this emulator, its source code and associated
+// readme files, with or without modification, are permitted in any medium without
+// royalty provided this copyright notice is used and wavemotion-dave is thanked profusely.
+//
+// The DS994a emulator is offered as-is, without any warranty.
+//
+// Please see the README.md file as it contains much useful info.
+// =====================================================================================
+#include <nds.h>
+#include <string.h>
+
+#include "scheduler.h"
+#include "disk.h"
+#include "cpu/tms9900/tms9900.h"
+#include "cpu/tms9900/tms9901.h"
+
+// ---------------------------------------------------------------------------------------------
+// The event scheduler. Rather than the CPU checking on the rest of the system after every
+// instruction (or every scanline), anything that needs to happen at a particular time is
+// put here keyed on the absolute CPU cycle. The CPU core runs until sched.next and then we
+// dispatch whatever is due. Only a handful of events so a simple array is plenty fast.
+// ---------------------------------------------------------------------------------------------
+Scheduler sched __attribute__((section(".dtcm")));
+
+// ---------------------------------------------------------------------------
+// Find the earliest active event. The scanline is always active so there
+// is always something for the CPU to run towards.
+// ---------------------------------------------------------------------------
+static inline void Scheduler_UpdateNext(void)
+{
+    u32 next = sched.when[EVT_SCANLINE];
+
+    for (u8 evt = EVT_SCANLINE+1; evt < EVT_MAX; evt++)
+    {
+        if (EVENT_ACTIVE(evt) && ((s32)(sched.when[evt] - next) < 0)) next = sched.when[evt];
+    }
+
+    sched.next = next;
+}
+
+// ---------------------------------------------------------------------------
+// Start over with just the end of the first scanline scheduled.
+// ---------------------------------------------------------------------------
+void Scheduler_Reset(void)
+{
+    memset(&sched, 0x00, sizeof(sched));
+    Scheduler_Add(EVT_SCANLINE, tms9900.cycles + SCANLINE_CYCLES - tms9900.cycleDelta);
+}
+
+// ---------------------------------------------------------------------------
+// Schedule (or re-schedule) an event at the given absolute CPU cycle.
+// ---------------------------------------------------------------------------
+void Scheduler_Add(u8 event, u32 when)
+{
+    sched.when[event] = when;
+    sched.active |= (1 << event);
+    Scheduler_UpdateNext();
+}
+
+void Scheduler_Cancel(u8 event)
+{
+    sched.active &= ~(1 << event);
+    Scheduler_UpdateNext();
+}
+
+// -------------------------------------------------------------------------------------------
+// Called when the CPU has run up to sched.next. Fire everything that is now due and return
+// a bitmask of what fired so the main loop knows if the scanline is complete. Events that
+// repeat are re-scheduled relative to when they were due (not when we got around to them)
+// so the small overshoot at the end of each CPU run never accumulates.
+// -------------------------------------------------------------------------------------------
+ITCM_CODE u32 Scheduler_Dispatch(void)
+{
+    u32 fired = 0;
+
+    for (u8 evt = 0; evt < EVT_MAX; evt++)
+    {
+        if (EVENT_ACTIVE(evt) && ((s32)(tms9900.cycles - sched.when[evt]) >= 0))
+        {
+            u32 due = sched.when[evt];
+            sched.active &= ~(1 << evt);
+            fired |= (1 << evt);
+
+            switch (evt)
+            {
+                case EVT_SCANLINE:
+                    tms9900.cycleDelta = tms9900.cycles - due;
+                    sched.when[EVT_SCANLINE] = due + SCANLINE_CYCLES;
+                    sched.active |= (1 << EVT_SCANLINE);
+                    break;
+
+                case EVT_TIMER9901:
+                    TMS9901_TimerExpired(due);
+                    break;
+
+                case EVT_DISK_MOTOR:
+                    disk_motor_timeout();
+                    break;
+            }
+        }
+    }
+
+    Scheduler_UpdateNext();
+
+    return fired;
+}
+
+// -------------------------------------------------------------------------------------------
+// The save state holds the time to the next scanline as the TMS9900 cycleDelta (the overage
+// into the current line) and the 9901 timer as its counter... so bring those up to date
+// before saving and rebuild the schedule from them after loading.
+// -------------------------------------------------------------------------------------------
+void Scheduler_SaveState(void)
+{
+    tms9900.cycleDelta = tms9900.cycles + SCANLINE_CYCLES - sched.when[EVT_SCANLINE];
+    TMS9901_TimerSync();
+}
+
+void Scheduler_RestoreState(void)
+{
+    Scheduler_Reset();
+    TMS9901_TimerRun();
+    if (motorOn) Scheduler_Add(EVT_DISK_MOTOR, tms9900.cycles + DISK_MOTOR_CYCLES);
+}
+
+// End of file
@@ -0,0 +1,54 @@
+// =====================================================================================
+// Copyright (c) 2023-2026 Dave Bernazzani (wavemotion-dave)
+//
+// Copying and distribution of this emulator, its source code and associated
+// readme files, with or without modification, are permitted in any medium without
+// royalty provided this copyright notice is used and wavemotion-dave is thanked profusely.
+//
+// The DS994a emulator is offered as-is, without any warranty.
+//
+// Please see the README.md file as it contains much useful info.
+// =====================================================================================
+#ifndef _SCHEDULER_H_
+#define _SCHEDULER_H_
+
+#include <nds.h>
+
+#define SCANLINE_CYCLES     191     // There are 191 CPU clocks per line on the TI
+
+// ----------------------------------------------------------------------------------------
+// The things that can happen at a particular CPU cycle. The CPU runs uninterrupted until
+// the earliest of these is due... the VDP scanline (which also handles the VBlank IRQ and
+// the per-line audio sampling) is always scheduled - the others only when they're active.
+// ----------------------------------------------------------------------------------------
+enum _EVENTS
+{
+    EVT_SCANLINE = 0,       // End of the current scanline - time to let the VDP render it
+    EVT_TIMER9901,          // The TMS9901 timer has counted down to zero
+    EVT_DISK_MOTOR,         // The disk controller motor strobe has timed out
+    EVT_MAX
+};
+
+// ----------------------------------------------------------------------------------------
+// All times are absolute CPU cycles (tms9900.cycles) and are always compared as a signed
+// difference so that the 32-bit cycle counter can safely wrap around.
+// ----------------------------------------------------------------------------------------
+typedef struct _Scheduler
+{
+    u32     next;               // The cycle at which the earliest active event is due - the CPU runs until this
+    u32     active;             // Bitmask of the events currently scheduled
+    u32     when[EVT_MAX];      // The cycle each event is due
+} Scheduler;
+
+extern Scheduler sched;
+
+#define EVENT_ACTIVE(evt)   (sched.active & (1 << (evt)))
+
+extern void Scheduler_Reset(void);
+extern void Scheduler_Add(u8 event, u32 when);
+extern void Scheduler_Cancel(u8 event);
+extern u32  Scheduler_Dispatch(void);
+extern void Scheduler_SaveState(void);
+extern void Scheduler_RestoreState(void);
+
+#endif
@@ -98,9 +98,6 @@ bool screenshotbmp(const char* filename) {
     fwrite(temp, 1, 256 * 192 * 2 + sizeof(INFOHEADER) + sizeof(HEADER), file);
     fclose(file);
 
-    // Since we over-wrote the VRAM_D[] which has our opcode table, we have to rebuild it...
-    extern void TMS9900_buildopcodes(void);
-    TMS9900_buildopcodes();
     return true;
 }
 